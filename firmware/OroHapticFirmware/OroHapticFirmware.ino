@@ -13,6 +13,7 @@
  * - I2C: SDA=D4 (pin 4), SCL=D5 (pin 5)
  * - Battery Monitor: A0 (analog pin for voltage divider)
  * - I2S Audio: BCLK=D1, LRCLK=D0, DIN=D2, SD=D6
+ * - Haptic Trigger (optional): DRV2605L IN/TRIG=D3
  *
  * Author: Oro Development Team
  * Date: 2025-11-06
@@ -24,6 +25,16 @@
 #include <math.h>
 #include "LSM6DS3.h"  // Use Seeed_Arduino_LSM6DS3 library
 #include "audio_i2s.h"  // I2S audio playback for MAX98357A
+#include "haptic_drv2605.h"  // DRV2605L waveform sequencer (non-blocking cue chains)
+#include "stroke_detector.h"  // Catch/drive/finish/recovery state machine (host-replayable)
+#include <Adafruit_LittleFS.h>
+#include <InternalFileSystem.h>  // Flash-backed storage for calibration data
+
+using namespace Adafruit_LittleFS_Namespace;
+
+// Firmware version (advertised in manufacturer data)
+#define FIRMWARE_VERSION_MAJOR 1
+#define FIRMWARE_VERSION_MINOR 0
 
 // ============================================================================
 // HARDWARE CONFIGURATION
@@ -39,12 +50,24 @@
 #define I2S_DIN_PIN   0  // D0 - Data In
 #define I2S_SD_PIN    6  // D6 - Shutdown (active-high, LOW=mute)
 
+// DRV2605L Actuator: HAPTIC_ACTUATOR_ERM (current hardware) or HAPTIC_ACTUATOR_LRA
+#define HAPTIC_ACTUATOR HAPTIC_ACTUATOR_ERM
+#define HAPTIC_CAL_FILE "/haptic_cal.bin"  // Persisted LRA auto-calibration results
+#define HAPTIC_CAL_MAGIC 0x4F43            // Marks a valid calibration record
+
+// DRV2605L Hardware Trigger (optional - IN/TRIG wired to D3)
+// Set to 1 only when IN/TRIG is wired: in external trigger mode the I2C GO bit is not used
+#define HAPTIC_HW_TRIGGER 0
+#define HAPTIC_TRIG_GPIO 29  // D3 = GPIO P0.29 (actual GPIO number, not the D-number)
+#define PACE_EDGE_GRACE_US 2000  // An armed, unfired edge this close to the beat is still on its way
+
 // Battery Monitoring
 #define BATTERY_PIN A0
 #define BATTERY_READ_INTERVAL 30000  // Read every 30 seconds
 
 // DRV2605L Configuration
 Adafruit_DRV2605 drv;
+HapticDRV2605 hapticDriver;  // Sequencer playback (cue chains without delay())
 
 // LSM6DS3 IMU Configuration (built-in on XIAO Sense, I2C address 0x6A)
 LSM6DS3 imu(I2C_MODE, 0x6A);
@@ -55,9 +78,122 @@ AudioI2S audioPlayer;
 // IMU Stroke Detection Settings
 #define IMU_SAMPLE_RATE_HZ 104       // 104 Hz sampling rate
 #define STROKE_DETECT_THRESHOLD 1.0  // Acceleration threshold in g (based on real paddle data: peak ~1.83g, using 55%)
-#define STROKE_MIN_INTERVAL_MS 200   // Minimum time between strokes (prevents double-counting)
 #define CALIBRATION_SAMPLES 10      // Number of samples for calibration
 
+// Haptic artifact blanking: the ERM vibration couples straight into the IMU, so samples taken
+// while our own effect is playing are replaced with the last clean value
+#define HAPTIC_BLANK_SETTLE_MS 30      // ERM spin-down time after the effect ends (no active braking)
+
+// Custom haptic pattern library (uploaded over BLE, stored in flash)
+#define CUSTOM_PATTERN_BASE 0x80       // Pattern IDs 0x80+ refer to the custom library
+#define CUSTOM_PATTERN_SLOTS 16        // IDs 0x80-0x8F
+#define CUSTOM_PATTERN_NAME_LEN 12
+#define CUSTOM_PATTERN_MAX_PAYLOAD (HAPTIC_RTP_MAX_POINTS * 3)  // Envelope point = amplitude + uint16 duration
+#define CUSTOM_PATTERN_MAX_ENVELOPE_MS 2000  // Longest envelope: RTP holds flash writes and serial off the loop
+#define CUSTOM_PATTERN_FILE "/haptic_patterns.bin"
+#define CUSTOM_PATTERN_MAGIC 0x5054
+
+// Per-stroke telemetry records, batched into one notification while the link is busy
+#define STROKE_RECORD_SIZE 16
+#define STROKE_BATCH_HEADER 2             // [sequence][record count]
+#define STROKE_BATCH_MAX_RECORDS 15       // 2 + 15 * 16 = 242 bytes, fits an MTU of 247
+#define STROKE_RING_RECORDS 128           // Unsent records held while a link is stalled or dropped (~4 min)
+
+// Telemetry TX queue - every notification goes through it so a full SoftDevice queue loses nothing
+#define TX_CREDITS 3                      // HVN TX buffers per link (BANDWIDTH_MAX hvn_qsize)
+#define TX_EVENT_QUEUE_LEN 16             // One-shot notifications (acks, legacy stroke events)
+#define TX_EVENT_ACK_RESERVE 4            // Entries only acks may use - other events never crowd them out
+#define TX_ACK_HOLD_MS 1000               // Longest a write waits for room for its ack
+#define TX_MAX_VALUE_LEN 12                // Largest queued value (command batch ack)
+
+// Connection-event aligned TX: the SoftDevice radio notification (SWI1) fires this long before
+// each radio event; queued telemetry is handed over then, so it carries the freshest values
+#define RADIO_NOTIFICATION_LEAD_US 1740   // NRF_RADIO_NOTIFICATION_DISTANCE_1740US
+#define RADIO_NOTIFICATION_IRQ_PRIORITY 6 // Application low (SoftDevice reserves 0, 1 and 4)
+#define RADIO_TX_HOLD_SLACK_US 2000       // Never hold data longer than one interval plus this
+
+// Device status publishing: state changes go out immediately, stroke/battery-only changes at most this often
+#define STATUS_MIN_INTERVAL_MS 1000
+
+// Batched command characteristic
+#define COMMAND_BATCH_MAX 8               // TLV commands per write (one status byte each in the ack)
+#define COMMAND_BATCH_MAX_LEN (1 + COMMAND_BATCH_MAX * 10)  // [seq] + commands up to an 8-byte value
+#define COMMAND_ACK_HISTORY 8             // Recent acks kept so pipelined retries are recognized
+
+// Deferred write execution - BLE write callbacks only copy the payload into this queue
+#define DEFERRED_WRITE_QUEUE_LEN 16       // Power of two (free-running 8-bit indices)
+#define DEFERRED_WRITE_MAX_LEN (BLE_PREFERRED_MTU - 3)  // Largest deferred value (a full bulk upload frame)
+#define DEFERRED_LINK_EVENT_RESERVE (3 * BLE_MAX_LINKS)  // Entries writes leave free for connect/secured/disconnect
+
+// State snapshot - everything the app reads after connecting, in one ATT read
+#define SNAPSHOT_VERSION 1
+#define SNAPSHOT_LEN 22                   // Fits one read at the default MTU (23 - 1)
+
+// Snapshot capability bits (what this firmware supports)
+#define SNAPSHOT_CAP_COMMAND 0x01
+#define SNAPSHOT_CAP_TIME_SYNC 0x02
+#define SNAPSHOT_CAP_STROKE_RECORDS 0x04
+#define SNAPSHOT_CAP_PATTERN_UPLOAD 0x08
+#define SNAPSHOT_CAP_BULK 0x10
+#define SNAPSHOT_CAP_AUDIO 0x20
+
+// Snapshot flag bits (current state, some per reading central)
+#define SNAPSHOT_FLAG_TIME_SYNCED 0x01
+#define SNAPSHOT_FLAG_HAS_CONTROL 0x02
+#define SNAPSHOT_FLAG_BONDED 0x04
+#define SNAPSHOT_FLAG_CUSTOM_PATTERNS 0x08
+#define SNAPSHOT_FLAG_LATENCY_PROFILE 0x10
+#define SNAPSHOT_FLAG_CALIBRATING 0x20
+#define SNAPSHOT_FLAG_TIMED_PACING 0x40
+
+// Bulk transfer over GATT (file download/upload, throughput test) with app-level credits
+#define BULK_FRAME_HEADER 2               // [op][sequence]
+#define BULK_RESERVED_CREDITS 1           // SoftDevice buffers bulk data leaves for telemetry
+#define BULK_UPLOAD_WINDOW 8              // Upload frames the central may have in flight (< deferred queue)
+#define BULK_PATH_MAX 32
+#define BULK_ASSET_DIR "/assets"          // Uploads are stored here only
+#define BULK_SESSION_DIR "/sessions"      // Downloads are served from here and BULK_ASSET_DIR only
+#define BULK_TEST_MAX_SECONDS 30
+#define BULK_TEST_HISTORY 4               // Throughput results kept for serial 'u'
+
+// Clock synchronization with the phone (NTP-style ping/pong rounds, minimum-RTT sample per round)
+#define TIME_SYNC_PINGS 8                 // Round trips per round
+#define TIME_SYNC_PING_SPACING_MS 40      // Gap between pings (lands them on different connection events)
+#define TIME_SYNC_PING_TIMEOUT_MS 500     // Pong not received - counted lost, next ping sent
+#define TIME_SYNC_SESSION_INTERVAL_MS 30000  // Re-sync period while training or calibrating
+#define TIME_SYNC_IDLE_INTERVAL_MS 120000    // Re-sync period otherwise
+#define TIME_SYNC_HISTORY 8               // Rounds in the offset/drift fit
+
+// Status in advertising manufacturer data - readable by scanners without connecting
+#define ADV_COMPANY_ID 0xFFFF             // Bluetooth SIG "no company" ID (testing / internal use)
+#define ADV_STATUS_LEN 6
+#define ADV_STATUS_MIN_INTERVAL_MS 2000   // Stroke/battery-only changes; state changes go out immediately
+#define ADV_SET_HANDLE 0                  // The one advertising set Bluefruit configures
+
+// Disconnect-tolerant sessions: training continues on-device, the session central gets
+// directed advertising and its missed stroke records on reconnect
+#define BLE_REQUEST_BONDING 1             // Ask each central to bond (Just Works) so reconnects skip discovery
+#define BLE_CONN_CFG_TAG_PERIPHERAL 1     // Bluefruit's connection configuration tag for peripheral links
+#define RECONNECT_SUBSCRIBE_GRACE_MS 10000  // Hold records this long after connect for CCCDs to be restored
+#define SESSION_ORPHAN_TIMEOUT_MS 1800000UL  // Stop a session after 30 min without any central
+
+// Concurrent centrals (e.g. athlete phone + coach tablet)
+#define BLE_MAX_LINKS 2
+#define CONTROL_LEASE_MS 30000         // An idle controller can be taken over after this (outside a session)
+
+// Link negotiation requested on connect (the central may grant less)
+#define BLE_PREFERRED_MTU 247          // Largest ATT MTU that fits a single 251-byte LL PDU
+#define BLE_LINK_POLL_INTERVAL_MS 500  // How often negotiated link values are checked
+
+// Connection parameter profiles (interval in 1.25ms units, supervision timeout in 10ms units)
+#define CONN_ACTIVE_INTERVAL 6         // 7.5ms while training, calibrating or streaming
+#define CONN_ACTIVE_LATENCY 0
+#define CONN_IDLE_INTERVAL 120         // 150ms when idle
+#define CONN_IDLE_LATENCY 4            // Skip up to 4 events (~750ms) with nothing to send
+#define CONN_SUPERVISION_TIMEOUT 400   // 4s
+#define CONN_SETTLE_MS 5000            // Keep the fast initial interval for service discovery
+#define CONN_STREAM_HOLD_MS 3000       // Stay fast this long after the last bulk transfer
+
 // ============================================================================
 // BLE SERVICE AND CHARACTERISTIC UUIDs
 // ============================================================================
@@ -73,6 +209,12 @@ AudioI2S audioPlayer;
 #define STROKE_EVENT_CHAR_UUID      "12340005-1234-5678-1234-56789abcdef0"  // Notify - stroke detection events
 #define CALIBRATION_CHAR_UUID       "12340006-1234-5678-1234-56789abcdef0"  // Write/Notify - calibration control
 #define AUDIO_CONTROL_CHAR_UUID     "12340007-1234-5678-1234-56789abcdef0"  // Write - trigger audio prompts
+#define PATTERN_UPLOAD_CHAR_UUID    "12340008-1234-5678-1234-56789abcdef0"  // Write/Notify - custom pattern upload
+#define STROKE_RECORD_CHAR_UUID     "12340009-1234-5678-1234-56789abcdef0"  // Notify - batched per-stroke records
+#define TIME_SYNC_CHAR_UUID         "1234000A-1234-5678-1234-56789abcdef0"  // Write/Notify - clock synchronization
+#define COMMAND_CHAR_UUID           "1234000B-1234-5678-1234-56789abcdef0"  // Write/Notify - batched TLV commands
+#define BULK_CHAR_UUID              "1234000C-1234-5678-1234-56789abcdef0"  // Write/Notify - bulk transfer
+#define SNAPSHOT_CHAR_UUID          "1234000D-1234-5678-1234-56789abcdef0"  // Read - state snapshot
 
 // Standard Battery Service
 #define BATTERY_SERVICE_UUID        "180F"
@@ -98,7 +240,7 @@ BLECharacteristic zoneSettingsChar = BLECharacteristic(ZONE_SETTINGS_CHAR_UUID);
 BLECharacteristic deviceStatusChar = BLECharacteristic(DEVICE_STATUS_CHAR_UUID);
 
 // Connection Status: Read + Notify
-// Format: [connected(1 byte)][rssi(1 byte signed)]
+// Format: [connected(1 byte)][rssi(1 byte signed)][mtu(2 bytes)][data_length(2 bytes)][phy(1 byte)]
 BLECharacteristic connectionStatusChar = BLECharacteristic(CONNECTION_STATUS_CHAR_UUID);
 
 // Battery Level: Read + Notify (standard format: 0-100%)
@@ -116,6 +258,30 @@ BLECharacteristic calibrationChar = BLECharacteristic(CALIBRATION_CHAR_UUID);
 // Format: [audio_event(1 byte)][volume(1 byte)]
 BLECharacteristic audioControlChar = BLECharacteristic(AUDIO_CONTROL_CHAR_UUID);
 
+// Pattern Upload: Write + Notify
+// Format: [op(1 byte)][op-specific payload] - notify: [op(1 byte)][pattern_id(1 byte)][status(1 byte)]
+BLECharacteristic patternUploadChar = BLECharacteristic(PATTERN_UPLOAD_CHAR_UUID);
+
+// Stroke Records: Notify only
+// Format: [sequence(1 byte)][count(1 byte)][count x 16-byte stroke record]
+BLECharacteristic strokeRecordChar = BLECharacteristic(STROKE_RECORD_CHAR_UUID);
+
+// Time Sync: Write + Notify
+// Format: write [op(1 byte)][op-specific payload] - notify: [op(1 byte)][op-specific payload]
+BLECharacteristic timeSyncChar = BLECharacteristic(TIME_SYNC_CHAR_UUID);
+
+// Command: Write + Notify
+// Format: [seq(1 byte)][type(1 byte)][length(1 byte)][value]... - notify: [seq][result][count][status x count]
+BLECharacteristic commandChar = BLECharacteristic(COMMAND_CHAR_UUID);
+
+// Bulk Transfer: Write (with or without response) + Notify
+// Format: [op(1 byte)][op-specific payload] in both directions
+BLECharacteristic bulkChar = BLECharacteristic(BULK_CHAR_UUID);
+
+// State Snapshot: Read only, encoded for the reading central at read time
+// Format: see encodeStateSnapshot()
+BLECharacteristic snapshotChar = BLECharacteristic(SNAPSHOT_CHAR_UUID);
+
 // ============================================================================
 // DEVICE STATE MANAGEMENT
 // ============================================================================
@@ -139,7 +305,8 @@ enum HapticCommand {
   CMD_PAUSE_TRAINING = 0x03,
   CMD_RESUME_TRAINING = 0x04,
   CMD_COMPLETE_TRAINING = 0x05,
-  CMD_TEST_PATTERN = 0x06
+  CMD_TEST_PATTERN = 0x06,
+  CMD_CALIBRATE_ACTUATOR = 0x07
 };
 
 // Calibration Commands
@@ -150,14 +317,6 @@ enum CalibrationCommand {
   CAL_CMD_GET_STATUS = 0x04
 };
 
-// Stroke Phases
-enum StrokePhase {
-  STROKE_PHASE_CATCH = 0x01,    // Start of stroke (paddle entry/catch)
-  STROKE_PHASE_DRIVE = 0x02,    // Power phase (drive/pull)
-  STROKE_PHASE_FINISH = 0x03,   // End of stroke (finish/extraction)
-  STROKE_PHASE_RECOVERY = 0x04  // Return to catch position
-};
-
 // Haptic Patterns (DRV2605L effect library)
 enum HapticPattern {
   PATTERN_STRONG_CLICK = 1,      // Sharp single click
@@ -170,6 +329,99 @@ enum HapticPattern {
   PATTERN_ALERT_750MS = 24       // Long alert
 };
 
+// Haptic cue chains (DRV2605L sequencer entries)
+// Stroke pulse chained with the transition pattern between sets
+const uint8_t SET_TRANSITION_CUE[] = {PATTERN_STRONG_CLICK, HAPTIC_WAIT(50), PATTERN_DOUBLE_CLICK};
+// Session completion (alert, 50ms gap, triple click), and the same chained behind the final stroke pulse
+const uint8_t TRAINING_COMPLETE_CUE[] = {PATTERN_ALERT_750MS, HAPTIC_WAIT(50), PATTERN_TRIPLE_CLICK};
+const uint8_t FINAL_STROKE_CUE[] = {PATTERN_STRONG_CLICK, HAPTIC_WAIT(50),
+                                    PATTERN_ALERT_750MS, HAPTIC_WAIT(50), PATTERN_TRIPLE_CLICK};
+
+// Custom pattern upload
+enum CustomPatternType {
+  CUSTOM_PATTERN_SEQUENCE = 0,   // DRV2605L sequencer chain (library effects and waits)
+  CUSTOM_PATTERN_ENVELOPE = 1    // RTP amplitude envelope (scaled by intensity)
+};
+
+enum PatternUploadOp {
+  PATTERN_OP_BEGIN = 0x01,       // [op][id][type][count][name...]
+  PATTERN_OP_DATA = 0x02,        // [op][offset][payload...]
+  PATTERN_OP_COMMIT = 0x03,      // [op]
+  PATTERN_OP_DELETE = 0x04       // [op][id]
+};
+
+enum PatternUploadStatus {
+  PATTERN_STATUS_OK = 0x00,
+  PATTERN_STATUS_BAD_ID = 0x01,
+  PATTERN_STATUS_BAD_LENGTH = 0x02,
+  PATTERN_STATUS_BAD_OFFSET = 0x03,
+  PATTERN_STATUS_INVALID = 0x04,
+  PATTERN_STATUS_NO_UPLOAD = 0x05,
+  PATTERN_STATUS_FLASH_ERROR = 0x06
+};
+
+// Batched commands (TLV type byte)
+enum CommandType {
+  COMMAND_ZONE = 0x01,           // Zone Settings value (6-7 bytes)
+  COMMAND_THRESHOLD = 0x02,      // [threshold g x 100 (int16)]
+  COMMAND_START = 0x03,          // No value
+  COMMAND_PLAY_CUE = 0x04,       // [pattern][intensity]
+  COMMAND_HAPTIC = 0x05,         // Haptic Control value (1-5 bytes)
+  COMMAND_CALIBRATION = 0x06,    // Calibration value (1-3 bytes)
+  COMMAND_AUDIO = 0x07,          // Audio Control value (1-2 bytes)
+  COMMAND_PING = 0x08            // No value - acked only (command latency probe)
+};
+
+// Batch result (ack byte 1)
+enum CommandBatchResult {
+  BATCH_EXECUTED = 0x00,         // Every command ran, in order
+  BATCH_REJECTED = 0x01,         // A command failed validation - nothing ran
+  BATCH_MALFORMED = 0x02,        // TLV framing broken or too many commands - nothing ran
+  BATCH_NOT_CONTROLLER = 0x03    // Another central has control - nothing ran
+};
+
+// Per-command status (ack bytes 3+)
+enum CommandStatus {
+  COMMAND_OK = 0x00,
+  COMMAND_UNKNOWN_TYPE = 0x01,
+  COMMAND_BAD_LENGTH = 0x02,
+  COMMAND_INVALID_VALUE = 0x03,
+  COMMAND_NOT_ALLOWED = 0x04,    // Not possible in this state (e.g. start without a zone)
+  COMMAND_SKIPPED = 0x05         // Valid, but not run because another command was rejected
+};
+
+// Bulk transfer operations (byte 0 of a Bulk Transfer write / notification)
+enum BulkOp {
+  BULK_OP_READ = 0x01,           // Phone -> device: [credits(2)][path...] download a file
+  BULK_OP_CREDIT = 0x02,         // Phone -> device: [credits(2)] allow more data frames
+  BULK_OP_TEST = 0x03,           // Phone -> device: [seconds(1)][credits(2)] throughput test
+  BULK_OP_ABORT = 0x04,          // Phone -> device: stop the current transfer
+  BULK_OP_WRITE = 0x05,          // Phone -> device: [size(4)][name...] upload to /assets/name
+  BULK_OP_DATA = 0x06,           // Phone -> device: [payload] upload data
+  BULK_EVT_BEGIN = 0x80,         // Device -> phone: [size(4)] (0xFFFFFFFF for a test)
+  BULK_EVT_DATA = 0x81,          // Device -> phone: [seq][payload]
+  BULK_EVT_END = 0x82,           // Device -> phone: [status][bytes(4)]
+  BULK_EVT_CREDIT = 0x83,        // Device -> phone: [credits(2)] upload frames the device can take
+  BULK_EVT_RESULT = 0x84         // Device -> phone: [bytes(4)][ms(4)][mtu(2)][phy(1)]
+};
+
+enum BulkStatus {
+  BULK_STATUS_OK = 0x00,
+  BULK_STATUS_NOT_FOUND = 0x01,
+  BULK_STATUS_BUSY = 0x02,
+  BULK_STATUS_ABORTED = 0x03,
+  BULK_STATUS_FLASH_ERROR = 0x04,
+  BULK_STATUS_BAD_REQUEST = 0x05
+};
+
+// Time sync operations (byte 0 of a Time Sync write / notification)
+enum TimeSyncOp {
+  TIME_SYNC_OP_START = 0x01,     // Phone -> device: start a round now (this central becomes the reference)
+  TIME_SYNC_OP_PING = 0x02,      // Device -> phone: [seq][t1 device us(4)]
+  TIME_SYNC_OP_PONG = 0x03,      // Phone -> device: [seq][t2 phone us(8)][t3 phone us(8)]
+  TIME_SYNC_OP_RESULT = 0x04     // Device -> phone: [rounds][bound us(2)][error us(2)][drift ppm x10(2)]
+};
+
 // Audio Events
 enum AudioEvent {
   AUDIO_TRAINING_START = 0x01,    // Training session start beep
@@ -182,6 +434,12 @@ enum AudioEvent {
   AUDIO_RESUME = 0x08             // Resume beep
 };
 
+// How strokes are paced during a session
+enum PacingMode {
+  PACING_STROKE_DETECTION = 0,   // IMU stroke detection; the cue answers each detected stroke
+  PACING_TIMED = 1               // Cue on a fixed SPM beat, hardware-timed (TIMER3/PPI) when available
+};
+
 // Training Configuration
 struct TrainingConfig {
   uint16_t totalStrokes;
@@ -189,6 +447,8 @@ struct TrainingConfig {
   uint16_t strokesPerMinute;
   uint8_t zoneColor;
   bool isActive;
+  uint8_t strokePattern;  // Custom per-stroke cue (0 = zone color default)
+  uint8_t pacing;         // PacingMode
 };
 
 // Current Training State
@@ -199,32 +459,159 @@ struct TrainingState {
   uint8_t batteryLevel;
   unsigned long lastStrokeTime;
   unsigned long strokeInterval;  // Calculated from SPM
+  unsigned long nextPaceUs;      // micros() time of the next hardware-timed pacing pulse
+  bool paceArmed;                // Next pacing pulse is loaded and armed on TIMER3
+  uint32_t pacingFallbacks;      // Strokes whose armed pulse was lost and played in software
 };
 
-TrainingConfig trainingConfig = {0, 0, 0, 0, false};
-TrainingState trainingState = {STATE_IDLE, 0, 0, 100, 0, 0};
+TrainingConfig trainingConfig = {0, 0, 0, 0, false, 0, PACING_STROKE_DETECTION};
+TrainingState trainingState = {STATE_IDLE, 0, 0, 100, 0, 0, 0, false};
 
 // Stroke Detection State
 struct StrokeDetectionState {
   bool enabled;
   float threshold;               // Acceleration threshold in g
-  StrokePhase currentPhase;
-  unsigned long lastStrokeTime;
-  float maxAccel;                // Peak acceleration during current stroke
-  float minAccel;                // Minimum (most negative) during recovery
-  bool inStroke;                 // Currently in a stroke cycle
+  bool logSamples;               // Print every sample as an IMU CSV line (host replay capture)
 };
 
 StrokeDetectionState strokeDetection = {
   false,                         // disabled by default
   STROKE_DETECT_THRESHOLD,       // default threshold
-  STROKE_PHASE_RECOVERY,         // start in recovery phase
-  0,                             // no strokes yet
-  0.0,                           // no peak yet
-  0.0,                           // no minimum yet
-  false                          // not in stroke
+  false                          // sample log off
+};
+
+// Phase state machine and catch latency statistics (stroke_detector.h)
+StrokeDetector strokeDetector;
+
+// Haptic Artifact Blanking State
+struct HapticBlankingState {
+  unsigned long blankUntil;      // IMU samples before this time are motor-contaminated
+  float heldAccel;               // Last clean stroke-axis acceleration
+  float heldGyroRate;            // Last clean angular rate magnitude
+  uint32_t blankedSamples;       // Samples replaced since boot
+  bool wasBlanked;               // Previous sample was held
+};
+
+HapticBlankingState hapticBlanking = {0, 0.0, 0.0, 0, false};
+
+// Haptic arbitration - one cue owns the actuator at a time
+enum HapticPriority {
+  HAPTIC_PRIO_INFO = 0,   // Boot, connect/disconnect feedback
+  HAPTIC_PRIO_CONFIRM,    // Command acknowledgements (zone ACK, pause/resume/stop, tests)
+  HAPTIC_PRIO_SESSION,    // Training/calibration start and completion
+  HAPTIC_PRIO_PACING,     // Per-stroke cues - never held back by anything else
+  HAPTIC_PRIO_COUNT
+};
+
+// How long a cue may wait for the actuator before it is dropped (a late stroke cue misleads)
+const uint16_t HAPTIC_QUEUE_DEADLINE_MS[HAPTIC_PRIO_COUNT] = {1000, 1000, 2000, 100};
+
+struct HapticRequest {
+  uint8_t entries[HAPTIC_SEQ_SLOTS];
+  uint8_t count;                 // Sequencer entries (0 for an envelope)
+  HapticEnvelopePoint envelope[HAPTIC_RTP_MAX_POINTS];
+  uint8_t envelopeCount;         // RTP envelope points (0 for a sequence)
+  uint8_t intensity;
+  unsigned long queuedAt;
+  bool pending;
+};
+
+struct HapticPriorityStats {
+  uint32_t requested;
+  uint32_t immediate;            // Played without waiting
+  uint32_t queued;               // Waited for a cue of equal or higher priority
+  uint32_t coalesced;            // Replaced by a newer request of the same priority while waiting
+  uint32_t expired;              // Dropped after waiting past the deadline
+  uint32_t preempted;            // Cut off mid-waveform by a higher priority
+  uint32_t latencySumMs;         // Queue wait of cues that played after waiting
+  uint16_t latencyMaxMs;
+};
+
+struct HapticArbiterState {
+  HapticRequest queue[HAPTIC_PRIO_COUNT];  // One slot per priority - the newest request wins
+  HapticPriorityStats stats[HAPTIC_PRIO_COUNT];
+  bool active;                   // A cue (or armed pacing pulse) owns the actuator
+  uint8_t activePriority;
+};
+
+HapticArbiterState hapticArbiter = {};
+
+// Persisted actuator calibration record
+struct StoredHapticCalibration {
+  uint16_t magic;
+  uint8_t actuator;              // HapticActuator the values belong to
+  HapticCalibration values;
+};
+
+// Measured actuator response (IMU-observed vibration envelope)
+#define HAPTIC_RESPONSE_WINDOW_MS 400   // Capture window after the trigger
+#define HAPTIC_RESPONSE_MAX_SAMPLES 500
+#define HAPTIC_RESPONSE_BASELINE_SAMPLES 40
+#define HAPTIC_RESPONSE_SAMPLE_US 600   // Poll interval (accel runs at 1.66kHz while measuring)
+
+struct HapticResponse {
+  uint32_t onsetUs;              // Trigger to first detectable vibration
+  uint32_t startUs;              // Part of onsetUs spent on I2C: sequence load + GO write
+  uint16_t riseMs;               // 10% -> 90% of the peak vibration envelope
+  uint16_t fallMs;               // Last 90% point -> below 10% (spin-down / braking)
+  float peakG;                   // Peak vibration envelope
+};
+
+// Actuation latency self-test: request -> detectable vibration, per effect
+#define HAPTIC_LATENCY_FILE "/haptic_latency.bin"
+#define HAPTIC_LATENCY_MAGIC 0x4C55      // Bumped when the profile layout changes (re-run 'x')
+#define HAPTIC_LATENCY_EFFECTS 8        // One profile per HapticPattern
+#define HAPTIC_SELFTEST_TRIALS 4
+#define HAPTIC_SELFTEST_WINDOW_MS 150   // Onset and rise only - fall is not needed
+
+struct HapticLatencyProfile {
+  uint8_t effect;
+  uint8_t trials;                // Trials with a detected onset (0 = not measured)
+  uint32_t onsetMinUs;
+  uint32_t onsetAvgUs;
+  uint32_t onsetMaxUs;
+  uint32_t startAvgUs;           // I2C share of onsetAvgUs - absent when the edge trigger fires a loaded cue
+  uint16_t riseAvgMs;
+  uint16_t riseMaxMs;
+};
+
+struct StoredHapticLatency {
+  uint16_t magic;
+  uint8_t actuator;              // HapticActuator the profiles were measured on
+  uint8_t count;
+  HapticLatencyProfile profiles[HAPTIC_LATENCY_EFFECTS];
+};
+
+StoredHapticLatency hapticLatency = {};
+
+// Custom haptic pattern library (loaded into RAM at boot)
+struct CustomHapticPattern {
+  uint8_t id;                    // CUSTOM_PATTERN_BASE + slot, 0 = empty slot
+  uint8_t type;                  // CustomPatternType
+  uint8_t count;                 // Sequencer entries or envelope points
+  char name[CUSTOM_PATTERN_NAME_LEN + 1];
+  uint8_t sequence[HAPTIC_SEQ_SLOTS];
+  HapticEnvelopePoint envelope[HAPTIC_RTP_MAX_POINTS];
+};
+
+struct StoredPatternLibrary {
+  uint16_t magic;
+  CustomHapticPattern patterns[CUSTOM_PATTERN_SLOTS];
+};
+
+StoredPatternLibrary patternLibrary = {};
+
+// In-progress upload (BEGIN -> DATA... -> COMMIT)
+struct PatternUploadState {
+  bool active;
+  CustomHapticPattern pattern;   // Header from BEGIN
+  uint8_t payload[CUSTOM_PATTERN_MAX_PAYLOAD];
+  uint8_t expected;              // Payload bytes announced by BEGIN
+  uint8_t received;
 };
 
+PatternUploadState patternUpload = {};
+
 // Calibration State
 struct CalibrationState {
   bool active;
@@ -248,6 +635,368 @@ uint8_t lastBatteryLevel = 100;
 // Device name with BLE address suffix
 String deviceName = "Oro-0000";
 
+// Negotiated link parameters (MTU / DLE / PHY complete asynchronously after connect)
+struct LinkState {
+  uint16_t mtu;                  // ATT MTU
+  uint16_t dataLength;           // LL payload octets (27 without DLE)
+  uint8_t phy;                   // BLE_GAP_PHY_1MBPS / BLE_GAP_PHY_2MBPS
+  unsigned long lastPoll;
+  uint16_t interval;             // Effective connection interval (1.25ms units)
+  uint16_t latency;              // Effective slave latency
+  uint16_t timeout;              // Effective supervision timeout (10ms units)
+};
+
+// Connection parameters follow the device state: fast while cues and strokes flow, slow otherwise
+enum ConnProfile {
+  CONN_PROFILE_NONE = 0,         // Initial parameters chosen by the central
+  CONN_PROFILE_ACTIVE,
+  CONN_PROFILE_IDLE
+};
+
+struct ConnParamState {
+  uint8_t profile;               // Last requested ConnProfile
+  unsigned long connectedAt;
+  unsigned long streamUntil;     // Bulk transfer keeps the active profile until this time
+  uint16_t requests;             // Parameter update requests sent this connection
+};
+
+// One entry per connected central
+struct BleLink {
+  bool active;
+  uint16_t connHandle;
+  ble_gap_addr_t peerAddr;
+  bool bonded;                   // Encrypted with stored keys (set by handleLinkSecured)
+  ble_gap_id_key_t peerId;       // Bond identity (IRK + identity address), valid when bonded
+  LinkState link;
+  ConnParamState params;
+  uint8_t credits;               // Free SoftDevice HVN buffers on this link
+  volatile uint32_t txCompleted; // HVN_TX_COMPLETE packets (written by the BLE task only)
+  uint32_t txCompletedSeen;
+  uint8_t strokeSent;            // Ring records (from the head) already sent on this link
+  uint8_t strokeSequence;        // Stroke batch sequence as seen by this central
+  bool connStatusPending;        // Connection status carries per-link values, encoded at send time
+  bool statusPending;            // New link: owed the current device status (set on connect)
+  uint8_t statusSent[5];         // Device status last queued for this link
+  uint32_t notifications;        // Throughput statistics
+  uint32_t bytes;
+  uint32_t stalls;
+  uint32_t writes;               // Writes received from this central
+  uint32_t rejectedWrites;       // Control writes refused while another central had control
+  bool snapshotRead;             // Time-to-ready already recorded for this connection
+  uint8_t snapshot[SNAPSHOT_LEN]; // Encoded by the first part of a read; later parts of a long read use it
+};
+
+BleLink bleLinks[BLE_MAX_LINKS] = {};
+
+// Control arbitration - commands are accepted from one central at a time
+// Advertised status - updated in place while advertising (double-buffered for the SoftDevice)
+struct AdvertisingStatusState {
+  uint8_t advertised[ADV_STATUS_LEN];
+  uint8_t advData[2][BLE_GAP_ADV_SET_DATA_SIZE_MAX];   // The SoftDevice reads the old pair until
+  uint8_t scanData[2][BLE_GAP_ADV_SET_DATA_SIZE_MAX];  // the update is applied
+  uint8_t buffer;                // Pair handed over last
+  unsigned long lastUpdate;
+  uint32_t updates;
+  uint32_t failures;
+};
+
+AdvertisingStatusState advertisingStatus = {};
+
+// Session central that dropped out mid-session
+struct ReconnectState {
+  bool awaiting;                 // Holding its stroke records until it comes back
+  bool bonded;                   // Recognised by bond identity (it may use rotating private addresses)
+  ble_gap_addr_t peerAddr;       // Unbonded central: recognised by its connection address
+  ble_gap_id_key_t peerId;
+  uint8_t strokeSent;            // Ring records (from the head) it had already been sent
+  unsigned long disconnectedAt;
+  bool directedPending;          // Switch to directed advertising from loop()
+  bool directedActive;
+  volatile bool advertisingEnded;  // ADV_SET_TERMINATED (written by the BLE task only)
+  uint32_t dropouts;
+  uint32_t reconnects;
+  uint32_t recordsReplayed;
+};
+
+ReconnectState reconnectState = {};
+
+struct ControlArbiterState {
+  uint16_t owner;                // Connection handle of the controlling central
+  unsigned long lastCommand;
+};
+
+ControlArbiterState controlArbiter = {BLE_CONN_HANDLE_INVALID, 0};
+
+// Recent command batches - a retried write with the same sequence gets the same ack without re-running.
+// Sequences act as command IDs, so writes without response can be pipelined and retried safely.
+struct CommandAckRecord {
+  uint16_t connHandle;
+  uint8_t ack[3 + COMMAND_BATCH_MAX];
+  uint8_t ackLen;                // 0 = unused
+  uint32_t receivedUs;           // micros() in the write callback
+  bool timed;                    // Turnaround recorded (first transmission only)
+};
+
+struct CommandBatchState {
+  CommandAckRecord history[COMMAND_ACK_HISTORY];
+  uint8_t historyNext;
+  uint32_t batches;
+  uint32_t commands;
+  uint32_t rejected;
+  uint32_t duplicates;
+  uint32_t acksTimed;            // Write callback -> ack handed to the SoftDevice
+  uint32_t ackMinUs;
+  uint32_t ackMaxUs;
+  uint64_t ackTotalUs;
+};
+
+CommandBatchState commandBatch = {};
+
+// Characteristic a deferred write was addressed to
+enum DeferredWriteTarget {
+  DEFERRED_HAPTIC_CONTROL = 0,
+  DEFERRED_ZONE_SETTINGS,
+  DEFERRED_CALIBRATION,
+  DEFERRED_AUDIO_CONTROL,
+  DEFERRED_PATTERN_UPLOAD,
+  DEFERRED_COMMAND,
+  DEFERRED_BULK,
+  DEFERRED_LINK_CONNECTED,       // data: peer ble_gap_addr_t
+  DEFERRED_LINK_SECURED,         // Encrypted - bond identity checked (and the session resumed) in loop()
+  DEFERRED_LINK_DISCONNECTED     // data: HCI reason
+};
+
+struct DeferredWrite {
+  uint8_t target;                // DeferredWriteTarget
+  uint16_t connHandle;
+  uint32_t receivedUs;
+  uint16_t len;
+  uint8_t data[DEFERRED_WRITE_MAX_LEN];
+};
+
+// Single producer (Bluefruit callback task), single consumer (loop) - no locks needed
+struct DeferredWriteQueue {
+  DeferredWrite entries[DEFERRED_WRITE_QUEUE_LEN];
+  volatile uint8_t head;         // Next entry to run (written by loop only)
+  volatile uint8_t tail;         // Next free entry (written by the callback task only)
+
+  // Written by the callback task
+  uint32_t deferred;
+  uint32_t dropped;              // Queue full - write discarded
+  uint32_t callbackMaxUs;        // Time spent inside write callbacks
+  uint64_t callbackTotalUs;
+
+  // Written by loop
+  uint32_t executed;
+  uint32_t waitMaxUs;            // Callback -> start of execution
+  uint32_t runMaxUs;             // Longest handler
+  uint8_t maxDepth;
+  uint32_t heldForRtp;           // Passes a flash-writing entry waited for an RTP envelope
+  uint32_t heldForAck;           // Passes an acknowledged write waited for event queue room
+  bool ackHeld;
+  unsigned long ackHeldSince;
+};
+
+DeferredWriteQueue deferredWrites = {};
+
+// Stroke record batching
+// Stroke records stay in the ring until every subscribed link has been sent them
+// (each link keeps its own offset and batch sequence in BleLink)
+struct StrokeTelemetryState {
+  uint8_t ring[STROKE_RING_RECORDS][STROKE_RECORD_SIZE];
+  uint8_t head;                  // Oldest record not yet sent on every link
+  uint8_t count;                 // Records held
+  bool synced[STROKE_RING_RECORDS];  // Catch timestamp is on the synchronized clock
+  uint32_t queuedUs[STROKE_RING_RECORDS];  // micros() when the record was created (sample-to-air latency)
+  uint16_t strokeIndex;          // Running stroke number carried in each record
+  uint32_t recordsQueued;
+  uint32_t recordsOverflowed;    // Oldest overwritten after STROKE_RING_RECORDS unsent strokes
+  uint32_t notifications;
+  uint8_t maxDepth;
+};
+
+StrokeTelemetryState strokeTelemetry = {};
+
+// Radio event timing from the SoftDevice radio notification, and sample-to-air latency
+struct RadioTimingState {
+  bool aligned;                  // Hold telemetry until just before a radio event (serial 'o' toggles)
+  volatile bool windowPending;   // Notification seen since the last hand-over (set by the ISR)
+  volatile uint32_t lastActiveUs;  // micros() of the last notification (radio active in LEAD_US)
+  volatile uint32_t notifications;
+  uint32_t lastWindowUs;
+  uint32_t windows;              // Hand-overs triggered by a notification
+  uint32_t forced;               // Hand-overs after a missed notification
+
+  // Records handed over since the last notification, relative to the first hand-over
+  uint16_t pendingRecords;
+  uint32_t pendingAnchorUs;
+  int64_t pendingAgeSumUs;       // Sum of (anchor - record created)
+  int32_t pendingAgeMaxUs;
+  uint32_t pendingNotifications; // notifications count at the first hand-over
+
+  // Sample-to-air latency of stroke records (creation -> estimated radio event)
+  uint32_t latencyCount;
+  uint64_t latencySumUs;
+  uint32_t latencyMinUs;
+  uint32_t latencyMaxUs;
+};
+
+RadioTimingState radioTiming = {true};
+
+// Bulk transfer - one at a time, on one link
+enum BulkMode {
+  BULK_IDLE = 0,
+  BULK_READING,                  // File download
+  BULK_WRITING,                  // File upload
+  BULK_TESTING                   // Throughput test (generated data)
+};
+
+struct BulkTestResult {
+  uint32_t bytes;
+  uint32_t ms;
+  uint16_t mtu;
+  uint8_t phy;
+  uint16_t interval;             // 1.25ms units
+  uint16_t dataLength;
+};
+
+struct BulkTransferState {
+  uint8_t mode;
+  uint16_t connHandle;
+  uint16_t credits;              // Data frames the central still accepts (app-level flow control)
+  uint8_t sequence;
+  uint32_t size;                 // File size (download) or announced size (upload)
+  uint32_t bytes;                // Transferred so far
+  unsigned long startMs;
+  unsigned long testEndMs;
+  char path[BULK_PATH_MAX];
+
+  // Device -> phone control frames, sent ahead of data so ordering is kept
+  uint8_t control[12];
+  uint8_t controlLen;
+  bool finishing;                // END pending - back to idle once it is sent
+  bool resultPending;            // Throughput test: RESULT follows END
+  uint16_t creditGrant;          // Upload frames to grant back to the central
+
+  BulkTestResult results[BULK_TEST_HISTORY];
+  uint8_t resultCount;
+  uint32_t frames;
+  uint32_t creditStalls;         // Passes with data ready but no app credit
+};
+
+BulkTransferState bulk = {};
+File bulkFile(InternalFS);
+
+// Connect -> first snapshot read, per connection (written from the BLE task)
+struct SnapshotStats {
+  uint32_t reads;
+  uint32_t readyCount;
+  uint32_t readyMinMs;
+  uint32_t readyMaxMs;
+  uint32_t readySumMs;
+  uint32_t readyLastMs;
+};
+
+SnapshotStats snapshotStats = {};
+
+// Clock synchronization - maps device micros() onto the reference central's clock
+struct TimeSyncSample {
+  int64_t deviceUs;              // Device time of the sample (midpoint of the ping)
+  int64_t offsetUs;              // Phone time minus device time
+};
+
+struct TimeSyncState {
+  uint16_t connHandle;           // Central providing the reference clock
+  bool roundActive;
+  uint8_t sequence;
+  uint8_t pingsSent;
+  bool awaitingPong;
+  uint32_t pingT1;               // micros() when the outstanding ping was handed to the SoftDevice
+  unsigned long lastPing;
+  unsigned long lastRound;
+
+  // Written by the BLE task, consumed by serviceTimeSync()
+  volatile bool pongReady;
+  uint8_t pongSequence;
+  int64_t pongT2;
+  int64_t pongT3;
+  uint32_t pongT4;
+
+  // Best (minimum round-trip) exchange of the current round
+  uint32_t bestDelayUs;
+  TimeSyncSample best;
+
+  // Estimate: offset at the anchor plus drift since then
+  TimeSyncSample history[TIME_SYNC_HISTORY];
+  uint8_t historyCount;
+  uint8_t historyNext;
+  bool synced;
+  TimeSyncSample anchor;
+  float driftPpm;
+  uint32_t boundUs;              // Half the minimum RTT of the last round (worst-case asymmetry)
+  uint32_t errorUs;              // Last round: measured offset vs the offset predicted before it
+  float residualUs;              // RMS residual of the offset/drift fit
+
+  // 64-bit device clock (micros() wraps every ~71 minutes)
+  uint32_t lastMicros;
+  uint32_t microsHigh;
+
+  uint16_t rounds;
+  uint32_t pings;
+  uint32_t pongs;
+  uint32_t lostPings;
+};
+
+TimeSyncState timeSync = {BLE_CONN_HANDLE_INVALID};
+
+// Latest-value characteristics: a newer value replaces one that has not been sent yet
+enum TelemetrySlot {
+  TX_SLOT_DEVICE_STATUS = 0,
+  TX_SLOT_CALIBRATION,
+  TX_SLOT_BATTERY,
+  TX_SLOT_COUNT
+};
+
+// Encoded once, then notified on every link whose bit is set
+struct TelemetryValue {
+  BLECharacteristic* chr;
+  uint8_t data[TX_MAX_VALUE_LEN];
+  uint8_t len;
+  uint8_t pendingLinks;          // Bit per bleLinks[] entry still to be notified
+};
+
+struct TelemetryTxState {
+  TelemetryValue slots[TX_SLOT_COUNT];        // Coalesced, sent first
+  TelemetryValue events[TX_EVENT_QUEUE_LEN];  // FIFO, sent in order
+  uint8_t eventHead;
+  uint8_t eventCount;
+  uint32_t sent;
+  uint32_t coalesced;            // Values replaced before they were sent
+  uint32_t eventDrops;           // Non-ack events refused by a full FIFO (the reserve is left for acks)
+  uint32_t ackDrops;             // Acks refused after the write was held for TX_ACK_HOLD_MS
+  uint32_t failed;               // notify() refused despite a free credit (retried)
+  uint32_t stalls;               // Passes with data waiting and no credit
+  uint8_t maxEventDepth;
+};
+
+TelemetryTxState telemetryTx = {};
+
+// Device status publisher - notifies a link only when the snapshot differs from the last one
+// sent to it (BleLink::statusSent)
+struct StatusPublisherState {
+  uint8_t current[5];
+  bool dirty;                    // Some link is behind current, waiting for the rate limit
+  unsigned long lastPublish;
+  uint32_t requests;             // updateDeviceStatus() calls (one notification each before)
+  uint32_t published;
+  uint32_t trainingRequests;     // The same, counted while training
+  uint32_t trainingPublished;
+  unsigned long trainingMs;      // Time spent in STATE_TRAINING while connected
+  unsigned long lastTick;
+};
+
+StatusPublisherState statusPublisher = {};
+
 // ============================================================================
 // SETUP FUNCTIONS
 // ============================================================================
@@ -260,6 +1009,11 @@ void setup() {
   Serial.println("Hardware: XIAO nRF52840 Sense + DRV2605L");
   Serial.println();
 
+  // Flash filesystem for persisted calibration data and bulk uploads
+  InternalFS.begin();
+  InternalFS.mkdir(BULK_ASSET_DIR);
+  InternalFS.mkdir(BULK_SESSION_DIR);
+
   // Initialize I2C with custom pins
   Wire.begin();
   Wire.setClock(400000);  // 400kHz I2C
@@ -270,6 +1024,8 @@ void setup() {
     trainingState.deviceState = STATE_ERROR;
     while(1) { delay(1000); }  // Halt on critical error
   }
+  loadHapticLatencyProfile();
+  loadPatternLibrary();
 
   // Initialize LSM6DS3 IMU
   if (!initializeIMU()) {
@@ -322,7 +1078,7 @@ void setup() {
   Serial.println("g");
 
   // Play startup haptic
-  playHapticEffect(PATTERN_DOUBLE_CLICK, 100);
+  playHapticEffect(PATTERN_DOUBLE_CLICK, 100, HAPTIC_PRIO_INFO);
 }
 
 bool initializeDRV2605L() {
@@ -343,10 +1099,39 @@ bool initializeDRV2605L() {
     return false;
   }
 
-  // Configure for ERM motor
-  drv.selectLibrary(1);  // ERM library
   drv.setMode(DRV2605_MODE_INTTRIG);  // Internal trigger mode
 
+  // Attach sequencer playback
+  if (!hapticDriver.begin()) {
+    return false;
+  }
+
+  // Library, feedback loop and braking for the fitted actuator
+  if (!hapticDriver.configureActuator(HAPTIC_ACTUATOR)) {
+    Serial.println("Failed to configure haptic actuator");
+    return false;
+  }
+  Serial.println(HAPTIC_ACTUATOR == HAPTIC_ACTUATOR_LRA ? "Actuator: LRA (closed loop, braking)" : "Actuator: ERM");
+
+  // LRAs need auto-calibration: re-apply stored results, or calibrate on first boot
+  if (HAPTIC_ACTUATOR == HAPTIC_ACTUATOR_LRA) {
+    calibrateActuator(false);
+    while (hapticDriver.isBusy()) {  // First boot: finish before the trigger mode is set up
+      delay(HAPTIC_POLL_INTERVAL_MS);
+      hapticDriver.update();
+    }
+    serviceActuatorCalibration();
+  }
+
+#if HAPTIC_HW_TRIGGER
+  // Hardware-timed triggers through IN/TRIG (TIMER3 -> PPI -> GPIOTE)
+  if (hapticDriver.beginHardwareTrigger(HAPTIC_TRIG_GPIO)) {
+    Serial.println("DRV2605L hardware trigger enabled on D3");
+  } else {
+    Serial.println("WARNING: Hardware trigger setup failed - using I2C GO");
+  }
+#endif
+
   Serial.println("DRV2605L initialized successfully");
   return true;
 }
@@ -380,14 +1165,17 @@ bool initializeIMU() {
   Serial.print(testZ, 3);
   Serial.println("g");
 
+  strokeDetectorReset(strokeDetector);
   return true;
 }
 
 bool initializeBLE() {
   Serial.println("Initializing BLE...");
 
-  // Initialize Bluefruit
-  Bluefruit.begin();
+  // Initialize Bluefruit with large ATT MTU, DLE and a long connection event
+  // (must be configured before begin())
+  Bluefruit.configPrphBandwidth(BANDWIDTH_MAX);
+  Bluefruit.begin(BLE_MAX_LINKS, 0);  // Peripheral links, no central links
 
   // Generate device name with last 4 chars of BLE address
   char addressStr[18];
@@ -402,14 +1190,15 @@ bool initializeBLE() {
   // Set max power for better range
   Bluefruit.setTxPower(4);  // Max +4dBm
 
-  // Set connection parameters for low latency (7.5ms - 20ms)
+  // Preferred parameters for the initial connection (7.5ms - 20ms) - fast service discovery.
+  // serviceConnParams() switches to a state-driven profile once the link has settled.
   Bluefruit.Periph.setConnInterval(6, 16);  // Units of 1.25ms
 
   // Configure Oro Haptic Service
   oroHapticService.begin();
 
   // Haptic Control Characteristic (Write)
-  hapticControlChar.setProperties(CHR_PROPS_WRITE);
+  hapticControlChar.setProperties(CHR_PROPS_WRITE | CHR_PROPS_WRITE_WO_RESP);
   hapticControlChar.setPermission(SECMODE_OPEN, SECMODE_OPEN);
   hapticControlChar.setFixedLen(5);
   hapticControlChar.setWriteCallback(onHapticControlWrite);
@@ -418,7 +1207,7 @@ bool initializeBLE() {
   // Zone Settings Characteristic (Write)
   zoneSettingsChar.setProperties(CHR_PROPS_WRITE);
   zoneSettingsChar.setPermission(SECMODE_OPEN, SECMODE_OPEN);
-  zoneSettingsChar.setFixedLen(6);
+  zoneSettingsChar.setMaxLen(7);  // Optional 7th byte: custom stroke pattern ID
   zoneSettingsChar.setWriteCallback(onZoneSettingsWrite);
   zoneSettingsChar.begin();
 
@@ -431,7 +1220,7 @@ bool initializeBLE() {
   // Connection Status Characteristic (Read + Notify)
   connectionStatusChar.setProperties(CHR_PROPS_READ | CHR_PROPS_NOTIFY);
   connectionStatusChar.setPermission(SECMODE_OPEN, SECMODE_NO_ACCESS);
-  connectionStatusChar.setFixedLen(2);
+  connectionStatusChar.setFixedLen(7);
   connectionStatusChar.begin();
 
   // Stroke Event Characteristic (Notify only)
@@ -448,12 +1237,54 @@ bool initializeBLE() {
   calibrationChar.begin();
 
   // Audio Control Characteristic (Write)
-  audioControlChar.setProperties(CHR_PROPS_WRITE);
+  audioControlChar.setProperties(CHR_PROPS_WRITE | CHR_PROPS_WRITE_WO_RESP);
   audioControlChar.setPermission(SECMODE_OPEN, SECMODE_OPEN);
   audioControlChar.setFixedLen(2);  // 1 byte audio event + 1 byte volume
   audioControlChar.setWriteCallback(onAudioControlWrite);
   audioControlChar.begin();
 
+  // Stroke Record Characteristic (Notify only)
+  strokeRecordChar.setProperties(CHR_PROPS_NOTIFY);
+  strokeRecordChar.setPermission(SECMODE_OPEN, SECMODE_NO_ACCESS);
+  strokeRecordChar.setMaxLen(STROKE_BATCH_HEADER + STROKE_BATCH_MAX_RECORDS * STROKE_RECORD_SIZE);
+  strokeRecordChar.begin();
+
+  // Pattern Upload Characteristic (Write + Notify)
+  patternUploadChar.setProperties(CHR_PROPS_WRITE | CHR_PROPS_NOTIFY);
+  patternUploadChar.setPermission(SECMODE_OPEN, SECMODE_OPEN);
+  patternUploadChar.setMaxLen(2 + CUSTOM_PATTERN_MAX_PAYLOAD);  // Whole pattern in one chunk once MTU allows
+  patternUploadChar.setWriteCallback(onPatternUploadWrite);
+  patternUploadChar.begin();
+
+  // Time Sync Characteristic (Write + Notify)
+  timeSyncChar.setProperties(CHR_PROPS_WRITE | CHR_PROPS_NOTIFY);
+  timeSyncChar.setPermission(SECMODE_OPEN, SECMODE_OPEN);
+  timeSyncChar.setMaxLen(18);
+  timeSyncChar.setWriteCallback(onTimeSyncWrite);
+  timeSyncChar.begin();
+
+  // Command Characteristic (Write + Notify)
+  commandChar.setProperties(CHR_PROPS_WRITE | CHR_PROPS_WRITE_WO_RESP | CHR_PROPS_NOTIFY);
+  commandChar.setPermission(SECMODE_OPEN, SECMODE_OPEN);
+  commandChar.setMaxLen(COMMAND_BATCH_MAX_LEN);
+  commandChar.setWriteCallback(onCommandWrite);
+  commandChar.begin();
+
+  // Bulk Transfer Characteristic (Write + Write Without Response + Notify)
+  // Encrypted links only - the central pairs (Just Works) on first access
+  bulkChar.setProperties(CHR_PROPS_WRITE | CHR_PROPS_WRITE_WO_RESP | CHR_PROPS_NOTIFY);
+  bulkChar.setPermission(SECMODE_ENC_NO_MITM, SECMODE_ENC_NO_MITM);
+  bulkChar.setMaxLen(BLE_PREFERRED_MTU - 3);
+  bulkChar.setWriteCallback(onBulkWrite);
+  bulkChar.begin();
+
+  // State Snapshot Characteristic (Read, value filled in per read)
+  snapshotChar.setProperties(CHR_PROPS_READ);
+  snapshotChar.setPermission(SECMODE_OPEN, SECMODE_NO_ACCESS);
+  snapshotChar.setFixedLen(SNAPSHOT_LEN);
+  snapshotChar.setReadAuthorizeCallback(onSnapshotRead);
+  snapshotChar.begin();
+
   // Configure Battery Service
   batteryService.begin();
 
@@ -468,15 +1299,23 @@ bool initializeBLE() {
   updateConnectionStatus();
   batteryLevelChar.write8(trainingState.batteryLevel);
 
+  // TX-complete events return notification credits to the telemetry queue
+  Bluefruit.setEventCallback(onBleEvent);
+  initializeRadioNotification();
+
   // Set connection callbacks
   Bluefruit.Periph.setConnectCallback(onBLEConnected);
   Bluefruit.Periph.setDisconnectCallback(onBLEDisconnected);
+  Bluefruit.Security.setSecuredCallback(onBLESecured);
 
-  // Start advertising
-  Bluefruit.Advertising.addFlags(BLE_GAP_ADV_FLAGS_LE_ONLY_GENERAL_DISC_MODE);
-  Bluefruit.Advertising.addTxPower();
-  Bluefruit.Advertising.addService(oroHapticService);
-  Bluefruit.Advertising.addName();
+  // Start advertising: flags, service UUID and status block (31 bytes); name and TX power
+  // go in the scan response
+  uint8_t status[ADV_STATUS_LEN];
+  encodeAdvertisingStatus(status);
+  memcpy(advertisingStatus.advertised, status, ADV_STATUS_LEN);
+  buildAdvertisingData(status);
+  Bluefruit.ScanResponse.addName();
+  Bluefruit.ScanResponse.addTxPower();
 
   // Set advertising interval (fast mode: 20ms, slow mode: 152.5ms)
   Bluefruit.Advertising.restartOnDisconnect(true);
@@ -497,8 +1336,8 @@ bool initializeBLE() {
 void loop() {
   // Bluefruit handles BLE automatically, no need to poll
 
-  // Check for serial commands
-  if (Serial.available()) {
+  // Check for serial commands (diagnostics block - not while an RTP envelope needs update())
+  if (Serial.available() && !hapticDriver.rtpPlaying()) {
     char cmd = Serial.read();
     if (cmd == 'i' || cmd == 'I') {
       // Print I2S debug info
@@ -548,6 +1387,51 @@ void loop() {
       Serial.println("  'c' - Cycle I2S channel mode (Stereo/Left/Right)");
       Serial.println("  's' - Speaker test (diagnose hardware issue)");
       Serial.println("  'w' - Check wiring (verify pin connections)");
+      Serial.println("  'k' - Catch detection latency (gyro-first vs accel-only)");
+      Serial.println("  'm' - Toggle IMU sample log (CSV for tools/catch_replay)");
+      Serial.println("  'd' - Haptic driver I2C bus statistics");
+      Serial.println("  'q' - Haptic arbiter queue statistics");
+      Serial.println("  'p' - List custom haptic patterns");
+      Serial.println("  'b' - Telemetry TX queue statistics");
+      Serial.println("  'n' - Per-link BLE statistics");
+      Serial.println("  'y' - Clock synchronization status");
+      Serial.println("  'o' - Toggle connection-event aligned TX (A/B latency)");
+      Serial.println("  'u' - Bulk transfer status and throughput results");
+      Serial.println("  'r' - Re-run actuator auto-calibration");
+      Serial.println("  'e' - Measure actuator rise/fall times (IMU)");
+      Serial.println("  'x' - Haptic latency self-test (saved, used for cue timing)");
+    } else if (cmd == 'k' || cmd == 'K') {
+      printCatchLatencyStats();
+    } else if (cmd == 'm' || cmd == 'M') {
+      strokeDetection.logSamples = !strokeDetection.logSamples;
+      Serial.print("IMU sample log now ");
+      Serial.println(strokeDetection.logSamples ? "ON (IMU,time_ms,accel_g,gyro_dps,reseed)" : "OFF");
+    } else if (cmd == 'd' || cmd == 'D') {
+      printHapticBusStats();
+    } else if (cmd == 'q' || cmd == 'Q') {
+      printHapticArbiterStats();
+    } else if (cmd == 'p' || cmd == 'P') {
+      printPatternLibrary();
+    } else if (cmd == 'b' || cmd == 'B') {
+      printTelemetryStats();
+    } else if (cmd == 'n' || cmd == 'N') {
+      printLinkStats();
+    } else if (cmd == 'y' || cmd == 'Y') {
+      printTimeSyncStatus();
+    } else if (cmd == 'u' || cmd == 'U') {
+      printBulkStatus();
+    } else if (cmd == 'o' || cmd == 'O') {
+      printRadioTiming();
+      radioTiming.aligned = !radioTiming.aligned;
+      resetRadioLatency();
+      Serial.print("Connection-event aligned TX now ");
+      Serial.println(radioTiming.aligned ? "ON" : "OFF");
+    } else if (cmd == 'r' || cmd == 'R') {
+      calibrateActuator(true);
+    } else if (cmd == 'e' || cmd == 'E') {
+      reportHapticResponse();
+    } else if (cmd == 'x' || cmd == 'X') {
+      runHapticLatencySelfTest();
     } else if (cmd == 't' || cmd == 'T') {
       // Test audio - NOW USES 100% VOLUME FOR MAXIMUM OUTPUT
       Serial.println("\n=== AUDIO TEST ===");
@@ -843,13 +1727,33 @@ void loop() {
     lastBatteryRead = millis();
   }
 
+  // Detect end of haptic sequences (GO bit polling), then start the next queued cue
+  hapticDriver.update();
+  audioPlayer.update();
+  serviceActuatorCalibration();
+  serviceDeferredWrites();  // BLE writes received since the last pass
+  serviceHapticArbiter();
+
   // Handle stroke detection (if enabled)
   if (strokeDetection.enabled || calibrationState.active) {
     handleStrokeDetection();
   }
 
-  // Handle training loop (time-based mode - deprecated in favor of IMU)
-  if (trainingState.deviceState == STATE_TRAINING && trainingConfig.isActive && !strokeDetection.enabled) {
+  // Publish rate-limited status changes, then send queued notifications as SoftDevice buffers free up
+  serviceStatusPublisher();
+  serviceAdvertisingStatus();
+  serviceTelemetryTx();
+
+  // Pick up MTU / DLE / PHY / connection parameter negotiation results
+  serviceLinkMonitor();
+  serviceConnParams();
+  serviceTimeSync();
+  serviceReconnect();
+
+  // Timed pacing (zone settings byte 7): the only mode whose cues can be scheduled ahead, so
+  // the only one that uses the hardware trigger
+  if (trainingState.deviceState == STATE_TRAINING && trainingConfig.isActive &&
+      trainingConfig.pacing == PACING_TIMED) {
     handleTrainingLoop();
   }
 
@@ -864,14 +1768,35 @@ void loop() {
 void handleTrainingLoop() {
   unsigned long currentTime = millis();
 
+  // Arm the next hardware-timed pulse once the previous cue has finished playing
+  if (hapticDriver.hardwareTriggerEnabled() && !trainingState.paceArmed && !hapticDriver.isBusy()) {
+    trainingState.paceArmed = armNextPacingPulse();
+  }
+
+  // With the hardware trigger, this stroke's pulse is fired by TIMER3/PPI
+  bool prePaced = hapticDriver.hardwareTriggerEnabled();
+
+  // Software pacing starts the cue early by the measured motor onset
+  static const uint8_t strokeCue[] = {PATTERN_STRONG_CLICK};
+  unsigned long leadMs = prePaced ? 0 : hapticOnsetLeadUs(strokeCue, sizeof(strokeCue), false) / 1000;
+  leadMs = min(leadMs, trainingState.strokeInterval / 2);
+
   // Check if it's time for next stroke
-  if (currentTime - trainingState.lastStrokeTime >= trainingState.strokeInterval) {
-    // Trigger haptic pulse
-    playHapticEffect(PATTERN_STRONG_CLICK, 100);
+  if ((long)(currentTime + leadMs - trainingState.lastStrokeTime) >= (long)trainingState.strokeInterval) {
+
+    // Did the armed edge go out? It may still be a moment away if it was armed late. If it
+    // was never armed (driver busy) or was cancelled (stop / preemption), pulse in software.
+    bool pulseSent = prePaced && trainingState.paceArmed &&
+                     (hapticDriver.triggerFired() ||
+                      (long)(micros() - trainingState.nextPaceUs) < (long)PACE_EDGE_GRACE_US);
+    if (prePaced && !pulseSent) {
+      trainingState.pacingFallbacks++;
+    }
 
     // Update stroke count
     trainingState.currentStroke++;
-    trainingState.lastStrokeTime = currentTime;
+    trainingState.lastStrokeTime = prePaced ? trainingState.lastStrokeTime + trainingState.strokeInterval
+                                            : currentTime + leadMs;
 
     // Update device status
     updateDeviceStatus();
@@ -883,12 +1808,25 @@ void handleTrainingLoop() {
 
       // Check if all sets complete
       if (trainingState.currentSet >= trainingConfig.totalSets) {
-        completeTraining();
-      } else {
-        // Play transition pattern between sets
-        delay(50);
-        playHapticEffect(PATTERN_DOUBLE_CLICK, 80);
+        // The armed pulse already played the completion cue; otherwise chain it behind the pulse
+        if (pulseSent) {
+          completeTraining(NULL, 0);
+        } else {
+          completeTraining(FINAL_STROKE_CUE, sizeof(FINAL_STROKE_CUE));
+        }
+      } else if (!pulseSent) {
+        // Stroke pulse chained with the transition pattern between sets
+        playHapticSequence(SET_TRANSITION_CUE, sizeof(SET_TRANSITION_CUE), HAPTIC_PRIO_PACING);
       }
+    } else if (!pulseSent) {
+      // Trigger haptic pulse
+      playHapticEffect(PATTERN_STRONG_CLICK, 100, HAPTIC_PRIO_PACING);
+    }
+
+    // The next pulse is armed a full interval ahead on the following pass
+    if (prePaced) {
+      trainingState.nextPaceUs += trainingState.strokeInterval * 1000UL;
+      trainingState.paceArmed = false;
     }
 
     // Print progress
@@ -905,6 +1843,40 @@ void handleTrainingLoop() {
   }
 }
 
+// Load the cue for the upcoming stroke and arm the hardware trigger to fire it at
+// trainingState.nextPaceUs, independent of loop() timing and I2C traffic
+// Returns true if a pulse was armed
+bool armNextPacingPulse() {
+  uint16_t nextStroke = trainingState.currentStroke + 1;
+  bool lastStrokeOfSet = nextStroke >= trainingConfig.totalStrokes;
+  bool lastSet = trainingState.currentSet + 1 >= trainingConfig.totalSets;
+
+  // The final stroke pulse carries the session completion cue, like a set transition
+  static const uint8_t strokeCue[] = {PATTERN_STRONG_CLICK};
+  const uint8_t* cue = strokeCue;
+  uint8_t cueLength = sizeof(strokeCue);
+  if (lastStrokeOfSet) {
+    cue = lastSet ? FINAL_STROKE_CUE : SET_TRANSITION_CUE;
+    cueLength = lastSet ? sizeof(FINAL_STROKE_CUE) : sizeof(SET_TRANSITION_CUE);
+  }
+
+  // Fire early by the measured motor onset (without the I2C start, which is done already)
+  // so the vibration itself lands on the beat
+  long delayUs = (long)(trainingState.nextPaceUs - hapticOnsetLeadUs(cue, cueLength, true) - micros());
+  if (delayUs < 0) {
+    delayUs = 0;
+  }
+
+  if (!hapticDriver.scheduleSequence(cue, cueLength, delayUs)) {
+    return false;
+  }
+
+  // The armed pulse owns the actuator; lower priorities may only borrow it (see serviceHapticArbiter)
+  hapticArbiter.active = true;
+  hapticArbiter.activePriority = HAPTIC_PRIO_PACING;
+  return true;
+}
+
 void startTraining() {
   if (!trainingConfig.isActive) {
     Serial.println("ERROR: Cannot start training - no zone configured");
@@ -919,9 +1891,11 @@ void startTraining() {
   Serial.print(" | SPM: ");
   Serial.println(trainingConfig.strokesPerMinute);
 
-  // Enable stroke detection (IMU mode)
-  strokeDetection.enabled = true;
-  Serial.println("Stroke detection ENABLED");
+  // IMU mode counts detected strokes; timed pacing counts beats and leaves the IMU alone
+  strokeDetection.enabled = trainingConfig.pacing != PACING_TIMED;
+  Serial.println(strokeDetection.enabled ? "Stroke detection ENABLED"
+                                         : (hapticDriver.hardwareTriggerEnabled() ? "Timed pacing (hardware trigger)"
+                                                                                 : "Timed pacing (software)"));
 
   // Calculate stroke interval from SPM (for time-based fallback)
   // SPM = strokes per minute, so interval = 60000ms / SPM
@@ -931,10 +1905,12 @@ void startTraining() {
   trainingState.currentStroke = 0;
   trainingState.currentSet = 0;
   trainingState.lastStrokeTime = millis();
+  trainingState.nextPaceUs = micros() + trainingState.strokeInterval * 1000UL;
+  trainingState.paceArmed = false;
   trainingState.deviceState = STATE_TRAINING;
 
   // Play start pattern
-  playHapticEffect(PATTERN_TRIPLE_CLICK, 100);
+  playHapticEffect(PATTERN_TRIPLE_CLICK, 100, HAPTIC_PRIO_SESSION);
 
   updateDeviceStatus();
 }
@@ -942,7 +1918,7 @@ void startTraining() {
 void pauseTraining() {
   Serial.println("Training paused");
   trainingState.deviceState = STATE_PAUSED;
-  playHapticEffect(PATTERN_SOFT_CLICK, 80);
+  playHapticEffect(PATTERN_SOFT_CLICK, 80, HAPTIC_PRIO_CONFIRM);
   updateDeviceStatus();
 }
 
@@ -950,19 +1926,23 @@ void resumeTraining() {
   Serial.println("Training resumed");
   trainingState.deviceState = STATE_TRAINING;
   trainingState.lastStrokeTime = millis();  // Reset timing
-  playHapticEffect(PATTERN_DOUBLE_CLICK, 80);
+  trainingState.nextPaceUs = micros() + trainingState.strokeInterval * 1000UL;
+  trainingState.paceArmed = false;
+  playHapticEffect(PATTERN_DOUBLE_CLICK, 80, HAPTIC_PRIO_CONFIRM);
   updateDeviceStatus();
 }
 
-void completeTraining() {
+// cue: TRAINING_COMPLETE_CUE, FINAL_STROKE_CUE when the session ends on a paced stroke,
+// or NULL when the armed hardware pulse has already played it
+void completeTraining(const uint8_t* cue, uint8_t cueLength) {
   Serial.println("=== Training Complete ===");
   trainingState.deviceState = STATE_COMPLETE;
   trainingConfig.isActive = false;
 
-  // Play completion pattern
-  playHapticEffect(PATTERN_ALERT_750MS, 100);
-  delay(800);
-  playHapticEffect(PATTERN_TRIPLE_CLICK, 80);
+  // Play completion pattern from the sequencer
+  if (cue) {
+    playHapticSequence(cue, cueLength, HAPTIC_PRIO_SESSION);
+  }
 
   updateDeviceStatus();
 }
@@ -974,7 +1954,7 @@ void stopTraining() {
   trainingState.currentSet = 0;
   trainingConfig.isActive = false;
 
-  playHapticEffect(PATTERN_SOFT_CLICK, 60);
+  playHapticEffect(PATTERN_SOFT_CLICK, 60, HAPTIC_PRIO_CONFIRM);
   updateDeviceStatus();
 }
 
@@ -982,164 +1962,868 @@ void stopTraining() {
 // HAPTIC CONTROL
 // ============================================================================
 
-void playHapticEffect(uint8_t effect, uint8_t intensity) {
-  // Note: DRV2605L waveform library effects have pre-defined intensities
-  // The intensity parameter is used to select effect variations, not to scale amplitude
-  // setRealtimeValue() only works in RTP mode, not Internal Trigger mode
+// Request a library effect through the arbiter (see requestHaptic)
+void playHapticEffect(uint8_t effect, uint8_t intensity, HapticPriority priority) {
+  requestHaptic(&effect, 1, intensity, priority);
+}
 
-  // For different intensities, use different waveform effects:
-  // - Low intensity: Use softer effects (PATTERN_SOFT_CLICK)
-  // - Medium intensity: Use moderate effects (PATTERN_STRONG_CLICK)
-  // - High intensity: Use strong effects (PATTERN_DOUBLE_CLICK, PATTERN_TRIPLE_CLICK)
+// Request a cue chain (effect IDs and HAPTIC_WAIT entries) through the arbiter
+void playHapticSequence(const uint8_t* entries, uint8_t count, HapticPriority priority) {
+  requestHaptic(entries, count, 100, priority);
+}
 
-  // Set waveform
-  drv.setWaveform(0, effect);
-  drv.setWaveform(1, 0);  // End of waveform
+// A higher priority cuts the playing cue off mid-waveform; a stroke cue also supersedes
+// the previous stroke cue. Anything else waits in its priority's slot, where a newer
+// request coalesces with (replaces) an older one that has not played yet.
+void requestHaptic(const uint8_t* entries, uint8_t count, uint8_t intensity, HapticPriority priority) {
+  if (intensity == 0 || count == 0) {
+    return;
+  }
 
-  // Play effect
-  drv.go();
+  HapticRequest req = {};
+  req.count = min(count, (uint8_t)HAPTIC_SEQ_SLOTS);
+  memcpy(req.entries, entries, req.count);
+  req.intensity = intensity;
+  submitHapticRequest(req, priority);
 }
 
-void testHapticPattern(uint8_t pattern, uint8_t intensity) {
-  Serial.print("Testing haptic pattern: ");
-  Serial.print(pattern);
-  Serial.print(" at intensity: ");
-  Serial.println(intensity);
+// Request an RTP amplitude envelope through the arbiter (custom patterns)
+void requestHapticEnvelope(const HapticEnvelopePoint* points, uint8_t count, uint8_t intensity, HapticPriority priority) {
+  if (intensity == 0 || count == 0) {
+    return;
+  }
 
-  playHapticEffect(pattern, intensity);
+  HapticRequest req = {};
+  req.envelopeCount = min(count, (uint8_t)HAPTIC_RTP_MAX_POINTS);
+  memcpy(req.envelope, points, req.envelopeCount * sizeof(HapticEnvelopePoint));
+  req.intensity = intensity;
+  submitHapticRequest(req, priority);
 }
 
-// ============================================================================
-// AUDIO CONTROL (I2S Audio Playback)
-// ============================================================================
-
-// Play audio event based on type
-void playAudioEvent(uint8_t audioEvent, uint8_t volume) {
-  Serial.print("Audio event: 0x");
-  Serial.print(audioEvent, HEX);
-  Serial.print(" (");
+void submitHapticRequest(const HapticRequest& req, HapticPriority priority) {
+  HapticPriorityStats& stats = hapticArbiter.stats[priority];
+  stats.requested++;
 
-  // Log and play the audio event
-  switch (audioEvent) {
-    case AUDIO_TRAINING_START:
-      Serial.print("Training Start");
-      // Three ascending beeps
-      audioPlayer.playTone(800, 100, volume);
-      delay(50);
-      audioPlayer.playTone(1000, 100, volume);
-      delay(50);
-      audioPlayer.playTone(1200, 100, volume);
-      break;
+  if (hapticArbiter.active && !hapticDriver.isBusy()) {
+    hapticArbiter.active = false;
+  }
 
-    case AUDIO_HALFWAY:
-      Serial.print("Halfway");
-      // Single medium beep
-      audioPlayer.playTone(1000, 150, volume);
-      break;
+  if (!hapticArbiter.active || priority > hapticArbiter.activePriority || priority == HAPTIC_PRIO_PACING) {
+    if (hapticArbiter.active) {
+      hapticArbiter.stats[hapticArbiter.activePriority].preempted++;
+      hapticDriver.stop();
+      trainingState.paceArmed = false;  // Re-armed by handleTrainingLoop if one was pending
+    }
+    stats.immediate++;
+    startHapticRequest(req, priority);
+    return;
+  }
 
-    case AUDIO_SET_COMPLETE:
-      Serial.print("Set Complete");
-      // Two quick beeps
-      audioPlayer.playTone(1200, 100, volume);
-      delay(100);
-      audioPlayer.playTone(1200, 100, volume);
-      break;
+  HapticRequest& slot = hapticArbiter.queue[priority];
+  unsigned long queuedAt = millis();
+  if (slot.pending) {
+    stats.coalesced++;
+    queuedAt = slot.queuedAt;  // A coalesced request keeps the original deadline
+  } else {
+    stats.queued++;
+  }
+  slot = req;
+  slot.queuedAt = queuedAt;
+  slot.pending = true;
+}
 
-    case AUDIO_LAST_SET:
-      Serial.print("Last Set");
-      // Long alert tone
-      audioPlayer.playTone(900, 400, volume);
-      break;
+// Called from loop() after hapticDriver.update(): expire stale requests and start the
+// highest-priority waiting cue once the actuator is free
+void serviceHapticArbiter() {
+  if (hapticArbiter.active && !hapticDriver.isBusy()) {
+    hapticArbiter.active = false;
+  }
 
-    case AUDIO_ZONE_TRANSITION:
-      Serial.print("Zone Transition");
-      // Sweep tone (low to high)
-      audioPlayer.playTone(800, 150, volume);
-      audioPlayer.playTone(1200, 150, volume);
-      break;
+  unsigned long now = millis();
+  int next = -1;
+  for (int p = HAPTIC_PRIO_COUNT - 1; p >= 0; p--) {
+    HapticRequest& req = hapticArbiter.queue[p];
+    if (!req.pending) continue;
+    if (now - req.queuedAt > HAPTIC_QUEUE_DEADLINE_MS[p]) {
+      req.pending = false;
+      hapticArbiter.stats[p].expired++;
+      continue;
+    }
+    if (next < 0) next = p;
+  }
+  if (next < 0) {
+    return;
+  }
 
-    case AUDIO_SESSION_COMPLETE:
-      Serial.print("Session Complete");
-      // Fanfare: ascending tones
-      audioPlayer.playTone(800, 120, volume);
-      delay(50);
-      audioPlayer.playTone(1000, 120, volume);
-      delay(50);
-      audioPlayer.playTone(1200, 120, volume);
-      delay(50);
-      audioPlayer.playTone(1400, 200, volume);
-      break;
+  HapticRequest& req = hapticArbiter.queue[next];
+  if (hapticArbiter.active) {
+    // An armed hardware pacing pulse only needs the actuator when its edge fires -
+    // borrow it if the queued cue finishes first, and let the pulse be re-armed after
+    if (!hapticPacingSlackFor(hapticRequestDurationMs(req))) {
+      return;
+    }
+    hapticDriver.stop();
+    trainingState.paceArmed = false;
+  }
 
-    case AUDIO_PAUSE:
-      Serial.print("Pause");
-      // Descending beep
-      audioPlayer.playTone(1000, 100, volume);
-      delay(50);
-      audioPlayer.playTone(800, 100, volume);
-      break;
+  HapticPriorityStats& stats = hapticArbiter.stats[next];
+  uint16_t waited = (uint16_t)min(now - req.queuedAt, 0xFFFFUL);
+  stats.latencySumMs += waited;
+  if (waited > stats.latencyMaxMs) stats.latencyMaxMs = waited;
 
-    case AUDIO_RESUME:
-      Serial.print("Resume");
-      // Ascending beep
-      audioPlayer.playTone(800, 100, volume);
-      delay(50);
-      audioPlayer.playTone(1000, 100, volume);
-      break;
+  req.pending = false;
+  startHapticRequest(req, (HapticPriority)next);
+}
 
-    default:
-      Serial.print("Unknown");
-      break;
+uint32_t hapticRequestDurationMs(const HapticRequest& req) {
+  if (req.envelopeCount > 0) {
+    uint32_t total = 0;
+    for (uint8_t i = 0; i < req.envelopeCount; i++) {
+      total += req.envelope[i].durationMs;
+    }
+    return total;
   }
+  return hapticSequenceDurationMs(req.entries, req.count);
+}
 
-  Serial.print(") at volume ");
-  Serial.println(volume);
+// True if an armed (not yet fired) hardware pacing pulse leaves room for durationMs of playback
+bool hapticPacingSlackFor(uint32_t durationMs) {
+  if (!hapticDriver.hardwareTriggerEnabled() || !trainingState.paceArmed ||
+      hapticArbiter.activePriority != HAPTIC_PRIO_PACING) {
+    return false;
+  }
+  long untilEdgeMs = (long)(trainingState.nextPaceUs - micros()) / 1000;
+  return untilEdgeMs > (long)(durationMs + HAPTIC_BLANK_SETTLE_MS);
 }
 
-// ============================================================================
-// BLE EVENT HANDLERS
-// ============================================================================
+void startHapticRequest(const HapticRequest& req, HapticPriority priority) {
+  hapticArbiter.active = true;
+  hapticArbiter.activePriority = priority;
 
-void onBLEConnected(uint16_t conn_handle) {
-  BLEConnection* connection = Bluefruit.Connection(conn_handle);
+  if (req.envelopeCount > 0) {
+    playHapticEnvelope(req.envelope, req.envelopeCount, req.intensity);
+  } else if (req.count == 1) {
+    startHapticEffect(req.entries[0], req.intensity);
+  } else {
+    startHapticSequence(req.entries, req.count);
+  }
+}
 
-  // Get peer address
-  ble_gap_addr_t peer_addr = connection->getPeerAddr();
+void startHapticEffect(uint8_t effect, uint8_t intensity) {
+  // DRV2605L library effects have fixed amplitude, so full intensity plays the ROM
+  // effect and anything lower streams an intensity-scaled RTP envelope instead
+  if (intensity == 0) {
+    return;
+  }
 
-  // Format address as string
+  if (intensity < 100) {
+    HapticEnvelopePoint envelope[HAPTIC_RTP_MAX_POINTS];
+    uint8_t count = hapticEnvelopeForEffect(effect, envelope);
+    if (count > 0) {
+      playHapticEnvelope(envelope, count, intensity);
+      return;
+    }
+    // No envelope for this effect - fall back to the fixed-amplitude ROM effect
+  }
+
+  startHapticSequence(&effect, 1);
+}
+
+// Play an RTP amplitude envelope scaled by intensity (0-100).
+// Returns immediately; the envelope is paced by the driver's hardware timer.
+void playHapticEnvelope(const HapticEnvelopePoint* points, uint8_t count, uint8_t intensity) {
+  uint32_t duration = 0;
+  for (uint8_t i = 0; i < count; i++) {
+    duration += points[i].durationMs;
+  }
+  hapticBlanking.blankUntil = millis() + duration + HAPTIC_BLANK_SETTLE_MS;
+
+  hapticDriver.playEnvelope(points, count, intensity);
+}
+
+// Build an RTP envelope approximating a library effect at full scale.
+// Returns the number of points written, or 0 if the effect has no envelope.
+uint8_t hapticEnvelopeForEffect(uint8_t effect, HapticEnvelopePoint* out) {
+  uint8_t level = 255;
+  uint8_t pulses = 1;
+  uint8_t n = 0;
+
+  switch (effect) {
+    case PATTERN_STRONG_CLICK: level = 255; break;
+    case PATTERN_SHARP_CLICK:  level = 200; break;
+    case PATTERN_SOFT_CLICK:   level = 140; break;
+    case PATTERN_DOUBLE_CLICK: pulses = 2; break;
+    case PATTERN_TRIPLE_CLICK: pulses = 3; break;
+
+    case PATTERN_ALERT_750MS:
+      out[n++] = {255, 0};
+      out[n++] = {255, 750};
+      out[n++] = {0, 0};
+      return n;
+
+    case PATTERN_PULSING:
+      for (uint8_t i = 0; i < 3; i++) {
+        out[n++] = {255, 80};
+        out[n++] = {0, 80};
+      }
+      return n;
+
+    case PATTERN_TRANSITION:
+      out[n++] = {255, 150};
+      out[n++] = {0, 150};
+      return n;
+
+    default:
+      return 0;
+  }
+
+  // Clicks: short full-level pulses separated by 60ms gaps
+  for (uint8_t i = 0; i < pulses; i++) {
+    if (i > 0) {
+      out[n++] = {0, 60};
+    }
+    out[n++] = {level, 0};
+    out[n++] = {level, 25};
+    out[n++] = {0, 0};
+  }
+  return n;
+}
+
+// Start a cue chain on the DRV2605L sequencer immediately (bypasses the arbiter).
+// Returns immediately; completion is tracked by hapticDriver.update() in loop().
+void startHapticSequence(const uint8_t* entries, uint8_t count) {
+  // Blank the IMU for the whole chain plus spin-down so our own vibration
+  // cannot drive stroke phase transitions
+  hapticBlanking.blankUntil = millis() + hapticSequenceDurationMs(entries, count) + HAPTIC_BLANK_SETTLE_MS;
+
+  hapticDriver.playSequence(entries, count);
+}
+
+// Approximate playback time of the DRV2605L ERM library effects used by the firmware
+uint16_t hapticEffectDurationMs(uint8_t effect) {
+  switch (effect) {
+    case PATTERN_STRONG_CLICK:
+    case PATTERN_SHARP_CLICK:
+    case PATTERN_SOFT_CLICK:
+      return 60;
+    case PATTERN_DOUBLE_CLICK:
+      return 160;
+    case PATTERN_TRIPLE_CLICK:
+      return 260;
+    case PATTERN_TRANSITION:
+      return 300;
+    case PATTERN_PULSING:
+      return 500;
+    case PATTERN_ALERT_750MS:
+      return 750;
+    default:
+      return 200;  // Unknown library effect - blank conservatively
+  }
+}
+
+uint32_t hapticSequenceDurationMs(const uint8_t* entries, uint8_t count) {
+  uint32_t total = 0;
+  for (uint8_t i = 0; i < count && i < HAPTIC_SEQ_SLOTS; i++) {
+    if (HAPTIC_IS_WAIT(entries[i])) {
+      total += (entries[i] & 0x7F) * HAPTIC_WAIT_UNIT_MS;
+    } else {
+      total += hapticEffectDurationMs(entries[i]);
+    }
+  }
+  return total;
+}
+
+bool isHapticBlanking() {
+  return (long)(hapticBlanking.blankUntil - millis()) > 0;
+}
+
+void printHapticArbiterStats() {
+  static const char* names[HAPTIC_PRIO_COUNT] = {"info", "confirm", "session", "pacing"};
+
+  Serial.println("\n=== HAPTIC ARBITER ===");
+  for (uint8_t p = 0; p < HAPTIC_PRIO_COUNT; p++) {
+    const HapticPriorityStats& stats = hapticArbiter.stats[p];
+    uint32_t waitedPlays = stats.queued - stats.expired;
+    Serial.print(names[p]);
+    Serial.print(": req ");
+    Serial.print(stats.requested);
+    Serial.print(" | now ");
+    Serial.print(stats.immediate);
+    Serial.print(" | queued ");
+    Serial.print(stats.queued);
+    Serial.print(" | coalesced ");
+    Serial.print(stats.coalesced);
+    Serial.print(" | expired ");
+    Serial.print(stats.expired);
+    Serial.print(" | preempted ");
+    Serial.print(stats.preempted);
+    if (waitedPlays > 0) {
+      Serial.print(" | wait avg ");
+      Serial.print(stats.latencySumMs / (float)waitedPlays, 1);
+      Serial.print("ms max ");
+      Serial.print(stats.latencyMaxMs);
+      Serial.print("ms");
+    }
+    Serial.println();
+  }
+  if (hapticDriver.hardwareTriggerEnabled()) {
+    Serial.print("Pacing pulses played in software (armed edge lost): ");
+    Serial.println(trainingState.pacingFallbacks);
+  }
+}
+
+void printHapticBusStats() {
+  const HapticBusStats& stats = hapticDriver.busStats();
+  Serial.println("\n=== HAPTIC DRIVER I2C BUS ===");
+  Serial.print("Write transactions: "); Serial.println(stats.transactions);
+  Serial.print("Bytes on bus:       "); Serial.println(stats.bytes);
+  Serial.print("Bus time (us):      "); Serial.println(stats.busTimeUs);
+  Serial.print("Skipped registers:  "); Serial.println(stats.skippedRegisters);
+  Serial.print("Skipped bytes:      "); Serial.println(stats.skippedBytes);
+  Serial.print("Saved bus time (us, est.): "); Serial.println(hapticDriver.savedBusTimeUs());
+  Serial.print("RTP amplitude writes: "); Serial.println(hapticDriver.rtpWriteCount());
+  Serial.print("RTP zero overrun max (us): "); Serial.println(hapticDriver.rtpMaxOverrunUs());
+}
+
+// Apply stored actuator calibration, or start the DRV2605L auto-calibration; the result is
+// stored by serviceActuatorCalibration(). It takes ~1.2s with no cues, so it is refused
+// during a session.
+bool calibrateActuator(bool force) {
+  if (hapticDriver.actuator() != HAPTIC_ACTUATOR_LRA) {
+    Serial.println("Actuator auto-calibration only applies to LRA builds");
+    return false;
+  }
+
+  StoredHapticCalibration stored;
+  if (!force && loadBlob(HAPTIC_CAL_FILE, &stored, sizeof(stored)) &&
+      stored.magic == HAPTIC_CAL_MAGIC && stored.actuator == HAPTIC_ACTUATOR_LRA) {
+    Serial.println("Applying stored LRA calibration");
+    return hapticDriver.applyCalibration(stored.values);
+  }
+
+  if (trainingState.deviceState == STATE_TRAINING || trainingState.deviceState == STATE_CALIBRATING) {
+    Serial.println("ERROR: Cannot auto-calibrate actuator during a session");
+    return false;
+  }
+
+  Serial.println("Running LRA auto-calibration (hold paddle still)...");
+  return hapticDriver.startAutoCalibration();
+}
+
+// Called from loop(): persist a finished auto-calibration
+void serviceActuatorCalibration() {
+  HapticCalibration result;
+  if (hapticDriver.pollAutoCalibration(result) != HAPTIC_AUTOCAL_DONE) {
+    return;
+  }
+
+  StoredHapticCalibration stored;
+  stored.magic = HAPTIC_CAL_MAGIC;
+  stored.actuator = HAPTIC_ACTUATOR_LRA;
+  stored.values = result;
+  saveBlob(HAPTIC_CAL_FILE, &stored, sizeof(stored));
+
+  Serial.print("LRA calibration: COMP=0x");
+  Serial.print(result.compensation, HEX);
+  Serial.print(" BEMF=0x");
+  Serial.print(result.backEmf, HEX);
+  Serial.print(" FEEDBACK=0x");
+  Serial.print(result.feedback, HEX);
+  Serial.print(" | Resonance: ");
+  Serial.print(hapticDriver.lraResonanceHz(), 1);
+  Serial.println(" Hz");
+}
+
+// Fire one effect and observe its vibration envelope in the accelerometer.
+// Onset is measured from the playback request, so it includes the I2C load and GO write.
+// Blocks for windowMs; the accelerometer runs at 1.66kHz / 400Hz bandwidth meanwhile.
+bool measureHapticResponse(uint8_t effect, HapticResponse& out, uint16_t windowMs) {
+  static uint32_t sampleUs[HAPTIC_RESPONSE_MAX_SAMPLES];
+  static float envelope[HAPTIC_RESPONSE_MAX_SAMPLES];
+
+  // The default 416Hz / 100Hz-bandwidth configuration smears a 20-40ms motor onset
+  uint8_t ctrl1 = 0;
+  imu.readRegister(&ctrl1, LSM6DS3_ACC_GYRO_CTRL1_XL);
+  imu.writeRegister(LSM6DS3_ACC_GYRO_CTRL1_XL,
+                    (ctrl1 & 0x0C) | LSM6DS3_ACC_GYRO_ODR_XL_1660Hz | LSM6DS3_ACC_GYRO_BW_XL_400Hz);
+  delay(5);
+
+  // Baseline: resting magnitude (gravity) and its noise
+  float sum = 0.0f;
+  float sumSq = 0.0f;
+  for (uint8_t i = 0; i < HAPTIC_RESPONSE_BASELINE_SAMPLES; i++) {
+    float ax = imu.readFloatAccelX();
+    float ay = imu.readFloatAccelY();
+    float az = imu.readFloatAccelZ();
+    float mag = sqrtf(ax * ax + ay * ay + az * az);
+    sum += mag;
+    sumSq += mag * mag;
+    delayMicroseconds(500);
+  }
+  float baseline = sum / HAPTIC_RESPONSE_BASELINE_SAMPLES;
+  float noise = sqrtf(max(0.0f, sumSq / HAPTIC_RESPONSE_BASELINE_SAMPLES - baseline * baseline));
+
+  // Trigger directly (no blanking - the vibration is what we want to see)
+  uint32_t t0 = micros();
+  hapticDriver.playEffect(effect);
+  uint32_t startUs = micros() - t0;  // The GO write has completed - the driver starts from here
+
+  // Rectified, smoothed deviation from the resting magnitude
+  uint16_t count = 0;
+  float smoothed = 0.0f;
+  while (count < HAPTIC_RESPONSE_MAX_SAMPLES && micros() - t0 < windowMs * 1000UL) {
+    float ax = imu.readFloatAccelX();
+    float ay = imu.readFloatAccelY();
+    float az = imu.readFloatAccelZ();
+    float deviation = fabsf(sqrtf(ax * ax + ay * ay + az * az) - baseline);
+    smoothed = smoothed * 0.6f + deviation * 0.4f;
+    sampleUs[count] = micros() - t0;
+    envelope[count] = smoothed;
+    count++;
+    delayMicroseconds(HAPTIC_RESPONSE_SAMPLE_US);
+    hapticDriver.update();
+  }
+
+  imu.writeRegister(LSM6DS3_ACC_GYRO_CTRL1_XL, ctrl1);
+
+  float peak = 0.0f;
+  for (uint16_t i = 0; i < count; i++) {
+    if (envelope[i] > peak) peak = envelope[i];
+  }
+  if (peak < noise * 4.0f || peak <= 0.0f) {
+    return false;  // No vibration distinguishable from resting noise
+  }
+
+  int onset = -1, rise90 = -1, last90 = -1, fall10 = -1;
+  for (uint16_t i = 0; i < count; i++) {
+    if (onset < 0 && envelope[i] >= peak * 0.1f) onset = i;
+    if (rise90 < 0 && envelope[i] >= peak * 0.9f) rise90 = i;
+    if (envelope[i] >= peak * 0.9f) last90 = i;
+  }
+  for (uint16_t i = last90; i < count; i++) {
+    if (envelope[i] < peak * 0.1f) {
+      fall10 = i;
+      break;
+    }
+  }
+
+  out.onsetUs = sampleUs[onset];
+  out.startUs = startUs;
+  out.riseMs = (sampleUs[rise90] - sampleUs[onset]) / 1000;
+  out.fallMs = fall10 >= 0 ? (sampleUs[fall10] - sampleUs[last90]) / 1000 : 0xFFFF;
+  out.peakG = peak;
+  return true;
+}
+
+void reportHapticResponse() {
+  if (trainingState.deviceState == STATE_TRAINING || trainingState.deviceState == STATE_CALIBRATING) {
+    Serial.println("ERROR: Cannot measure actuator response during a session");
+    return;
+  }
+
+  static const uint8_t effects[] = {PATTERN_STRONG_CLICK, PATTERN_SOFT_CLICK, PATTERN_ALERT_750MS};
+
+  Serial.println("\n=== ACTUATOR RESPONSE ===");
+  Serial.print("Actuator: ");
+  Serial.println(hapticDriver.actuator() == HAPTIC_ACTUATOR_LRA ? "LRA" : "ERM");
+  if (hapticDriver.actuator() == HAPTIC_ACTUATOR_LRA) {
+    Serial.print("Resonance: ");
+    Serial.print(hapticDriver.lraResonanceHz(), 1);
+    Serial.println(" Hz");
+  }
+
+  for (uint8_t i = 0; i < sizeof(effects); i++) {
+    HapticResponse response;
+    Serial.print("Effect ");
+    Serial.print(effects[i]);
+    if (measureHapticResponse(effects[i], response, HAPTIC_RESPONSE_WINDOW_MS)) {
+      Serial.print(": onset ");
+      Serial.print(response.onsetUs / 1000.0f, 1);
+      Serial.print("ms | rise ");
+      Serial.print(response.riseMs);
+      Serial.print("ms | fall ");
+      if (response.fallMs == 0xFFFF) {
+        Serial.print(">window");
+      } else {
+        Serial.print(response.fallMs);
+        Serial.print("ms");
+      }
+      Serial.print(" | peak ");
+      Serial.print(response.peakG, 3);
+      Serial.println("g");
+    } else {
+      Serial.println(": no vibration detected");
+    }
+    delay(300);  // Let the actuator settle between effects
+  }
+}
+
+// Fire every pattern effect HAPTIC_SELFTEST_TRIALS times, record onset latency and
+// rise time per effect, and persist the profiles for cue scheduling
+void runHapticLatencySelfTest() {
+  if (trainingState.deviceState == STATE_TRAINING || trainingState.deviceState == STATE_CALIBRATING) {
+    Serial.println("ERROR: Cannot run haptic self-test during a session");
+    return;
+  }
+
+  static const uint8_t effects[HAPTIC_LATENCY_EFFECTS] = {
+    PATTERN_STRONG_CLICK, PATTERN_SHARP_CLICK, PATTERN_SOFT_CLICK, PATTERN_DOUBLE_CLICK,
+    PATTERN_TRIPLE_CLICK, PATTERN_ALERT_750MS, PATTERN_PULSING, PATTERN_TRANSITION
+  };
+
+  Serial.println("\n=== HAPTIC LATENCY SELF-TEST (keep paddle still) ===");
+
+  StoredHapticLatency result = {};
+  result.magic = HAPTIC_LATENCY_MAGIC;
+  result.actuator = hapticDriver.actuator();
+  result.count = HAPTIC_LATENCY_EFFECTS;
+
+  for (uint8_t e = 0; e < HAPTIC_LATENCY_EFFECTS; e++) {
+    HapticLatencyProfile& profile = result.profiles[e];
+    profile.effect = effects[e];
+    profile.onsetMinUs = 0xFFFFFFFF;
+    uint32_t onsetSum = 0;
+    uint32_t startSum = 0;
+    uint32_t riseSum = 0;
+
+    for (uint8_t trial = 0; trial < HAPTIC_SELFTEST_TRIALS; trial++) {
+      HapticResponse response;
+      bool ok = measureHapticResponse(effects[e], response, HAPTIC_SELFTEST_WINDOW_MS);
+
+      // Let the effect finish and the motor spin down before the next baseline
+      while (hapticDriver.isBusy()) {
+        hapticDriver.update();
+        delay(5);
+      }
+      delay(150);
+
+      if (!ok) continue;
+      profile.trials++;
+      onsetSum += response.onsetUs;
+      startSum += response.startUs;
+      riseSum += response.riseMs;
+      if (response.onsetUs < profile.onsetMinUs) profile.onsetMinUs = response.onsetUs;
+      if (response.onsetUs > profile.onsetMaxUs) profile.onsetMaxUs = response.onsetUs;
+      if (response.riseMs > profile.riseMaxMs) profile.riseMaxMs = response.riseMs;
+    }
+
+    Serial.print("Effect ");
+    Serial.print(profile.effect);
+    if (profile.trials == 0) {
+      profile.onsetMinUs = 0;
+      Serial.println(": no vibration detected");
+      continue;
+    }
+    profile.onsetAvgUs = onsetSum / profile.trials;
+    profile.startAvgUs = startSum / profile.trials;
+    profile.riseAvgMs = riseSum / profile.trials;
+
+    Serial.print(": onset avg ");
+    Serial.print(profile.onsetAvgUs / 1000.0f, 1);
+    Serial.print("ms (");
+    Serial.print(profile.onsetMinUs / 1000.0f, 1);
+    Serial.print("-");
+    Serial.print(profile.onsetMaxUs / 1000.0f, 1);
+    Serial.print(") of which I2C+GO ");
+    Serial.print(profile.startAvgUs / 1000.0f, 1);
+    Serial.print("ms | rise avg ");
+    Serial.print(profile.riseAvgMs);
+    Serial.print("ms max ");
+    Serial.print(profile.riseMaxMs);
+    Serial.print("ms | n=");
+    Serial.println(profile.trials);
+  }
+
+  hapticLatency = result;
+  if (saveBlob(HAPTIC_LATENCY_FILE, &hapticLatency, sizeof(hapticLatency))) {
+    Serial.println("Latency profile saved");
+  }
+}
+
+void loadHapticLatencyProfile() {
+  StoredHapticLatency stored;
+  if (loadBlob(HAPTIC_LATENCY_FILE, &stored, sizeof(stored)) && stored.magic == HAPTIC_LATENCY_MAGIC &&
+      stored.actuator == hapticDriver.actuator()) {
+    hapticLatency = stored;
+    Serial.println("Haptic latency profile loaded");
+  } else {
+    Serial.println("No haptic latency profile - run self-test ('x') to enable onset compensation");
+  }
+}
+
+// Measured request-to-vibration latency of the first effect in a cue chain (0 if unknown).
+// Timing-critical cues are started this much early so the vibration lands on time.
+// edgeTrigger: the cue is already loaded and fired by the IN/TRIG edge, so the I2C sequence
+// load and GO write measured by the self-test are not part of its latency.
+uint32_t hapticOnsetLeadUs(const uint8_t* entries, uint8_t count, bool edgeTrigger) {
+  for (uint8_t i = 0; i < count; i++) {
+    if (HAPTIC_IS_WAIT(entries[i])) {
+      return 0;  // Chain starts with silence - nothing to lead
+    }
+    for (uint8_t p = 0; p < hapticLatency.count && p < HAPTIC_LATENCY_EFFECTS; p++) {
+      const HapticLatencyProfile& profile = hapticLatency.profiles[p];
+      if (profile.effect == entries[i] && profile.trials > 0) {
+        if (edgeTrigger) {
+          return profile.onsetAvgUs > profile.startAvgUs ? profile.onsetAvgUs - profile.startAvgUs : 0;
+        }
+        return profile.onsetAvgUs;
+      }
+    }
+    return 0;
+  }
+  return 0;
+}
+
+void testHapticPattern(uint8_t pattern, uint8_t intensity) {
+  Serial.print("Testing haptic pattern: ");
+  Serial.print(pattern);
+  Serial.print(" at intensity: ");
+  Serial.println(intensity);
+
+  playHapticPattern(pattern, intensity, HAPTIC_PRIO_CONFIRM);
+}
+
+// ============================================================================
+// AUDIO CONTROL (I2S Audio Playback)
+// ============================================================================
+
+// Play audio event based on type
+void playAudioEvent(uint8_t audioEvent, uint8_t volume) {
+  Serial.print("Audio event: 0x");
+  Serial.print(audioEvent, HEX);
+  Serial.print(" (");
+
+  // Queue the notes; loop() plays them through audioPlayer.update(). A new event replaces
+  // whatever is still playing so cues stay current.
+  audioPlayer.flush();
+  switch (audioEvent) {
+    case AUDIO_TRAINING_START:
+      Serial.print("Training Start");
+      // Three ascending beeps
+      audioPlayer.queueTone(800, 100, volume);
+      audioPlayer.queueTone(1000, 100, volume, 50);
+      audioPlayer.queueTone(1200, 100, volume, 50);
+      break;
+
+    case AUDIO_HALFWAY:
+      Serial.print("Halfway");
+      // Single medium beep
+      audioPlayer.queueTone(1000, 150, volume);
+      break;
+
+    case AUDIO_SET_COMPLETE:
+      Serial.print("Set Complete");
+      // Two quick beeps
+      audioPlayer.queueTone(1200, 100, volume);
+      audioPlayer.queueTone(1200, 100, volume, 100);
+      break;
+
+    case AUDIO_LAST_SET:
+      Serial.print("Last Set");
+      // Long alert tone
+      audioPlayer.queueTone(900, 400, volume);
+      break;
+
+    case AUDIO_ZONE_TRANSITION:
+      Serial.print("Zone Transition");
+      // Sweep tone (low to high)
+      audioPlayer.queueTone(800, 150, volume);
+      audioPlayer.queueTone(1200, 150, volume);
+      break;
+
+    case AUDIO_SESSION_COMPLETE:
+      Serial.print("Session Complete");
+      // Fanfare: ascending tones
+      audioPlayer.queueTone(800, 120, volume);
+      audioPlayer.queueTone(1000, 120, volume, 50);
+      audioPlayer.queueTone(1200, 120, volume, 50);
+      audioPlayer.queueTone(1400, 200, volume, 50);
+      break;
+
+    case AUDIO_PAUSE:
+      Serial.print("Pause");
+      // Descending beep
+      audioPlayer.queueTone(1000, 100, volume);
+      audioPlayer.queueTone(800, 100, volume, 50);
+      break;
+
+    case AUDIO_RESUME:
+      Serial.print("Resume");
+      // Ascending beep
+      audioPlayer.queueTone(800, 100, volume);
+      audioPlayer.queueTone(1000, 100, volume, 50);
+      break;
+
+    default:
+      Serial.print("Unknown");
+      break;
+  }
+
+  Serial.print(") at volume ");
+  Serial.println(volume);
+}
+
+// ============================================================================
+// BLE EVENT HANDLERS
+// ============================================================================
+
+// Connect and disconnect callbacks run in the Bluefruit callback task: they only capture what
+// is gone once the callback returns and queue the event behind any pending writes. The links,
+// telemetry queue, arbiters and haptics are changed from loop() (serviceDeferredWrites).
+
+void onBLEConnected(uint16_t conn_handle) {
+  BLEConnection* connection = Bluefruit.Connection(conn_handle);
+  ble_gap_addr_t peer_addr = connection->getPeerAddr();
+  deferLinkEvent(DEFERRED_LINK_CONNECTED, conn_handle, (const uint8_t*)&peer_addr, sizeof(peer_addr));
+}
+
+void onBLEDisconnected(uint16_t conn_handle, uint8_t reason) {
+  deferLinkEvent(DEFERRED_LINK_DISCONNECTED, conn_handle, &reason, 1);
+}
+
+void handleLinkConnected(uint16_t conn_handle, const ble_gap_addr_t& peer_addr) {
+  BLEConnection* connection = Bluefruit.Connection(conn_handle);
+  if (!connection || !connection->connected()) {
+    return;  // Already gone - its disconnect is queued behind this entry
+  }
+
+  uint8_t index = 0;
+  while (index < BLE_MAX_LINKS && bleLinks[index].active) index++;
+  if (index == BLE_MAX_LINKS) {
+    connection->disconnect();  // SoftDevice was configured for BLE_MAX_LINKS - should not happen
+    return;
+  }
+
+  BleLink& link = bleLinks[index];
+  memset(&link, 0, sizeof(link));
+  link.connHandle = conn_handle;
+  link.credits = TX_CREDITS;
+  link.strokeSent = strokeTelemetry.count;  // Only strokes from now on
+  link.statusPending = true;  // The other links' dedup is untouched
+  link.peerAddr = peer_addr;
+  link.link = {23, 27, BLE_GAP_PHY_1MBPS, millis(), 0, 0, 0};
+  link.params = {CONN_PROFILE_NONE, millis(), 0, 0};
+  __DMB();  // onBleEvent() (BLE task) counts TX completions only for active links
+  link.active = true;
+  reconnectState.directedActive = false;  // A connection ends directed advertising
+
+  // An unbonded session central is recognised by address here; a bonded one (whose address
+  // may have rotated) by its bond identity once the link is encrypted, in handleLinkSecured()
+  if (reconnectState.awaiting && !reconnectState.bonded &&
+      peer_addr.addr_type == reconnectState.peerAddr.addr_type &&
+      memcmp(peer_addr.addr, reconnectState.peerAddr.addr, BLE_GAP_ADDR_LEN) == 0) {
+    resumeSessionCentral(link);
+  }
+
+#if BLE_REQUEST_BONDING
+  // Security Request (non-blocking); Bluefruit answers the pairing and stores the bond,
+  // including CCCDs, so a bonded central is subscribed again as soon as the link is encrypted
+  ble_gap_sec_params_t security = {};
+  security.bond = 1;
+  security.io_caps = BLE_GAP_IO_CAPS_NONE;
+  sd_ble_gap_authenticate(conn_handle, &security);
+#endif
+
+  // Format address as string
   char addr_str[18];
   sprintf(addr_str, "%02X:%02X:%02X:%02X:%02X:%02X",
           peer_addr.addr[5], peer_addr.addr[4], peer_addr.addr[3],
           peer_addr.addr[2], peer_addr.addr[1], peer_addr.addr[0]);
 
-  Serial.println("BLE device connected: " + String(addr_str));
+  Serial.println("BLE device connected: " + String(addr_str) + " (link " + String(index) + ")");
+
+  // Ask for large packets and the faster PHY; results are picked up by serviceLinkMonitor()
+  connection->requestMtuExchange(BLE_PREFERRED_MTU);
+  connection->requestDataLengthUpdate();
+  connection->requestPHY(BLE_GAP_PHY_2MBPS);
+
   updateConnectionStatus();
 
+  // Advertising stops on connect - keep accepting centrals while links are free
+  if (Bluefruit.connected() < BLE_MAX_LINKS) {
+    Bluefruit.Advertising.start(0);
+  }
+
   // Play connection haptic
-  playHapticEffect(PATTERN_SOFT_CLICK, 60);
+  playHapticEffect(PATTERN_SOFT_CLICK, 60, HAPTIC_PRIO_INFO);
 }
 
-void onBLEDisconnected(uint16_t conn_handle, uint8_t reason) {
-  Serial.println("BLE device disconnected, reason: 0x");
+void handleLinkDisconnected(uint16_t conn_handle, uint8_t reason) {
+  Serial.print("BLE device disconnected, reason: 0x");
   Serial.println(reason, HEX);
 
-  // Stop training if active
-  if (trainingState.deviceState == STATE_TRAINING) {
-    stopTraining();
+  BleLink* dropped = NULL;
+  for (uint8_t i = 0; i < BLE_MAX_LINKS; i++) {
+    if (bleLinks[i].active && bleLinks[i].connHandle == conn_handle) {
+      bleLinks[i].active = false;
+      releaseLinkTx(i);
+      dropped = &bleLinks[i];
+    }
+  }
+
+  if (bulk.mode != BULK_IDLE && bulk.connHandle == conn_handle) {
+    endBulkTransfer(BULK_STATUS_ABORTED);
+    bulk.mode = BULK_IDLE;  // Nobody left to send END to
+    bulk.controlLen = 0;
+    bulk.finishing = false;
+  }
+
+  // Connection handles are reused - a new central (or this one, restarting its sequence
+  // numbers) must never be answered from this connection's acks
+  for (uint8_t i = 0; i < COMMAND_ACK_HISTORY; i++) {
+    if (commandBatch.history[i].connHandle == conn_handle) {
+      commandBatch.history[i].ackLen = 0;
+    }
+  }
+
+  // Keep the current clock estimate (it free-runs on the fitted drift) but stop pinging
+  if (timeSync.connHandle == conn_handle) {
+    timeSync.connHandle = BLE_CONN_HANDLE_INVALID;
+    timeSync.roundActive = false;
+    timeSync.awaitingPong = false;
+  }
+
+  // The session keeps running on-device. If the controlling central dropped mid-session, hold
+  // the stroke records it has not been sent and advertise directly to it.
+  bool wasController = controlArbiter.owner == conn_handle;
+  bool session = trainingState.deviceState == STATE_TRAINING ||
+                 trainingState.deviceState == STATE_PAUSED;
+  if (wasController && session && dropped) {
+    reconnectState.strokeSent = dropped->strokeSent;
+    reconnectState.peerAddr = dropped->peerAddr;
+    reconnectState.bonded = dropped->bonded;
+    reconnectState.peerId = dropped->peerId;
+    reconnectState.awaiting = true;
+    reconnectState.directedPending = dropped->bonded;  // Directed advertising needs a known peer
+    reconnectState.disconnectedAt = millis();
+    reconnectState.dropouts++;
+    Serial.println("Session central lost - training continues, holding stroke records");
+  }
+  if (wasController) {
+    controlArbiter.owner = BLE_CONN_HANDLE_INVALID;
   }
 
   updateConnectionStatus();
 
   // Play disconnection haptic
-  playHapticEffect(PATTERN_SOFT_CLICK, 40);
+  playHapticEffect(PATTERN_SOFT_CLICK, 40, HAPTIC_PRIO_INFO);
 }
 
-void onHapticControlWrite(uint16_t conn_hdl, BLECharacteristic* chr, uint8_t* data, uint16_t len) {
+void handleHapticControlWrite(uint16_t conn_hdl, uint8_t* data, uint16_t len) {
+  if (!acquireControl(conn_hdl)) {
+    return;
+  }
+
   // Format: [command(1)][intensity(1)][duration_ms(2)][pattern(1)]
   if (len < 1) {
     Serial.println("ERROR: Invalid haptic control data");
     return;
   }
 
+  executeHapticCommand(data, len);
+}
+
+void executeHapticCommand(const uint8_t* data, uint16_t len) {
   uint8_t command = data[0];
   uint8_t intensity = (len > 1) ? data[1] : 100;
   uint16_t duration = (len > 3) ? (data[2] | (data[3] << 8)) : 0;
@@ -1158,7 +2842,7 @@ void onHapticControlWrite(uint16_t conn_hdl, BLECharacteristic* chr, uint8_t* da
       break;
 
     case CMD_SINGLE_PULSE:
-      playHapticEffect(pattern, intensity);
+      playHapticPattern(pattern, intensity, HAPTIC_PRIO_CONFIRM);
       break;
 
     case CMD_START_TRAINING:
@@ -1174,20 +2858,28 @@ void onHapticControlWrite(uint16_t conn_hdl, BLECharacteristic* chr, uint8_t* da
       break;
 
     case CMD_COMPLETE_TRAINING:
-      completeTraining();
+      completeTraining(TRAINING_COMPLETE_CUE, sizeof(TRAINING_COMPLETE_CUE));
       break;
 
     case CMD_TEST_PATTERN:
       testHapticPattern(pattern, intensity);
       break;
 
+    case CMD_CALIBRATE_ACTUATOR:
+      calibrateActuator(true);
+      break;
+
     default:
       Serial.println("ERROR: Unknown haptic command");
       break;
   }
 }
 
-void onAudioControlWrite(uint16_t conn_hdl, BLECharacteristic* chr, uint8_t* data, uint16_t len) {
+void handleAudioControlWrite(uint16_t conn_hdl, uint8_t* data, uint16_t len) {
+  if (!acquireControl(conn_hdl)) {
+    return;
+  }
+
   // Format: [audio_event(1)][volume(1)]
   if (len < 1) {
     Serial.println("ERROR: Invalid audio control data");
@@ -1206,17 +2898,34 @@ void onAudioControlWrite(uint16_t conn_hdl, BLECharacteristic* chr, uint8_t* dat
   playAudioEvent(audioEvent, volume);
 }
 
-void onZoneSettingsWrite(uint16_t conn_hdl, BLECharacteristic* chr, uint8_t* data, uint16_t len) {
+void handleZoneSettingsWrite(uint16_t conn_hdl, uint8_t* data, uint16_t len) {
+  if (!acquireControl(conn_hdl)) {
+    return;
+  }
+
   // Format: [strokes(2)][sets(1)][spm(2)][zone_color(1)]
   if (len < 6) {
     Serial.println("ERROR: Invalid zone settings data");
     return;
   }
 
+  applyZoneSettings(data, len);
+}
+
+void applyZoneSettings(const uint8_t* data, uint16_t len) {
   trainingConfig.totalStrokes = data[0] | (data[1] << 8);
   trainingConfig.totalSets = data[2];
   trainingConfig.strokesPerMinute = data[3] | (data[4] << 8);
   trainingConfig.zoneColor = data[5];
+  trainingConfig.strokePattern = 0;
+  if (len > 6 && data[6] != 0) {
+    if (findCustomPattern(data[6])) {
+      trainingConfig.strokePattern = data[6];
+    } else {
+      Serial.println("WARNING: Unknown stroke pattern - using zone default");
+    }
+  }
+  trainingConfig.pacing = (len > 7 && data[7] == PACING_TIMED) ? PACING_TIMED : PACING_STROKE_DETECTION;
   trainingConfig.isActive = true;
 
   Serial.println("=== Zone Settings Received ===");
@@ -1228,6 +2937,12 @@ void onZoneSettingsWrite(uint16_t conn_hdl, BLECharacteristic* chr, uint8_t* dat
   Serial.println(trainingConfig.strokesPerMinute);
   Serial.print("Zone Color: 0x");
   Serial.println(trainingConfig.zoneColor, HEX);
+  if (trainingConfig.strokePattern != 0) {
+    Serial.print("Stroke Pattern: 0x");
+    Serial.println(trainingConfig.strokePattern, HEX);
+  }
+  Serial.print("Pacing: ");
+  Serial.println(trainingConfig.pacing == PACING_TIMED ? "timed" : "stroke detection");
 
   // Reset training state
   trainingState.currentStroke = 0;
@@ -1235,45 +2950,1491 @@ void onZoneSettingsWrite(uint16_t conn_hdl, BLECharacteristic* chr, uint8_t* dat
   trainingState.deviceState = STATE_READY;
 
   // Acknowledge with haptic
-  playHapticEffect(PATTERN_DOUBLE_CLICK, 80);
+  playHapticEffect(PATTERN_DOUBLE_CLICK, 80, HAPTIC_PRIO_CONFIRM);
 
   updateDeviceStatus();
 }
 
-// ============================================================================
-// BLE STATUS UPDATES
-// ============================================================================
-
-void updateDeviceStatus() {
-  // Format: [state(1)][current_stroke(2)][current_set(1)][battery(1)]
-  uint8_t status[5];
-  status[0] = trainingState.deviceState;
-  status[1] = trainingState.currentStroke & 0xFF;
-  status[2] = (trainingState.currentStroke >> 8) & 0xFF;
-  status[3] = trainingState.currentSet;
-  status[4] = trainingState.batteryLevel;
+// ----------------------------------------------------------------------------
+// Deferred write execution
+// ----------------------------------------------------------------------------
+
+// Write callbacks run in the Bluefruit callback task; anything slow there (I2C, audio
+// playback, flash, Serial) holds up every other BLE event, and loop() would race it on the
+// shared state. They only copy the value into deferredWrites, and loop() runs the handlers
+// in arrival order. Connect and disconnect go through the same queue, so a central's writes
+// are always handled between its connect and its disconnect. Handlers must not block
+// the loop either: audio events are queued to audioPlayer.update() and actuator
+// auto-calibration is polled by hapticDriver.update().
+
+// Writes may only fill the queue up to the reserve; link events may use all of it
+void deferEntry(DeferredWriteTarget target, uint16_t conn_hdl, const uint8_t* data, uint16_t len, uint8_t limit) {
+  uint32_t start = micros();
+  uint8_t tail = deferredWrites.tail;
+
+  if ((uint8_t)(tail - deferredWrites.head) >= limit) {
+    deferredWrites.dropped++;
+  } else {
+    DeferredWrite& entry = deferredWrites.entries[tail % DEFERRED_WRITE_QUEUE_LEN];
+    entry.target = target;
+    entry.connHandle = conn_hdl;
+    entry.receivedUs = start;
+    entry.len = min(len, (uint16_t)DEFERRED_WRITE_MAX_LEN);
+    memcpy(entry.data, data, entry.len);
+    __DMB();  // Entry contents visible before the index that publishes it
+    deferredWrites.tail = tail + 1;
+    deferredWrites.deferred++;
+  }
 
-  deviceStatusChar.write(status, 5);
-  if (Bluefruit.connected()) {
-    deviceStatusChar.notify(status, 5);
+  uint32_t spent = micros() - start;
+  deferredWrites.callbackTotalUs += spent;
+  if (spent > deferredWrites.callbackMaxUs) {
+    deferredWrites.callbackMaxUs = spent;
   }
 }
 
-void updateConnectionStatus() {
-  // Format: [connected(1)][rssi(1 signed)]
-  uint8_t status[2];
-  status[0] = Bluefruit.connected() ? 0x01 : 0x00;
-  status[1] = 0;  // RSSI not easily accessible on nRF52, set to 0
+void deferWrite(DeferredWriteTarget target, uint16_t conn_hdl, const uint8_t* data, uint16_t len) {
+  deferEntry(target, conn_hdl, data, len, DEFERRED_WRITE_QUEUE_LEN - DEFERRED_LINK_EVENT_RESERVE);
+}
 
-  connectionStatusChar.write(status, 2);
-  if (Bluefruit.connected()) {
-    connectionStatusChar.notify(status, 2);
-  }
+// A lost connect or disconnect would leave bleLinks[] wrong for good
+void deferLinkEvent(DeferredWriteTarget target, uint16_t conn_hdl, const uint8_t* data, uint16_t len) {
+  deferEntry(target, conn_hdl, data, len, DEFERRED_WRITE_QUEUE_LEN);
 }
 
-// ============================================================================
-// STROKE DETECTION AND CALIBRATION
-// ============================================================================
+void onHapticControlWrite(uint16_t conn_hdl, BLECharacteristic* chr, uint8_t* data, uint16_t len) {
+  deferWrite(DEFERRED_HAPTIC_CONTROL, conn_hdl, data, len);
+}
+
+void onZoneSettingsWrite(uint16_t conn_hdl, BLECharacteristic* chr, uint8_t* data, uint16_t len) {
+  deferWrite(DEFERRED_ZONE_SETTINGS, conn_hdl, data, len);
+}
+
+void onCalibrationWrite(uint16_t conn_hdl, BLECharacteristic* chr, uint8_t* data, uint16_t len) {
+  deferWrite(DEFERRED_CALIBRATION, conn_hdl, data, len);
+}
+
+void onAudioControlWrite(uint16_t conn_hdl, BLECharacteristic* chr, uint8_t* data, uint16_t len) {
+  deferWrite(DEFERRED_AUDIO_CONTROL, conn_hdl, data, len);
+}
+
+void onPatternUploadWrite(uint16_t conn_hdl, BLECharacteristic* chr, uint8_t* data, uint16_t len) {
+  deferWrite(DEFERRED_PATTERN_UPLOAD, conn_hdl, data, len);
+}
+
+void onCommandWrite(uint16_t conn_hdl, BLECharacteristic* chr, uint8_t* data, uint16_t len) {
+  deferWrite(DEFERRED_COMMAND, conn_hdl, data, len);
+}
+
+void onBulkWrite(uint16_t conn_hdl, BLECharacteristic* chr, uint8_t* data, uint16_t len) {
+  deferWrite(DEFERRED_BULK, conn_hdl, data, len);
+}
+
+// Called from loop(): run every queued write, oldest first
+void serviceDeferredWrites() {
+  uint8_t depth = deferredWrites.tail - deferredWrites.head;
+  if (depth > deferredWrites.maxDepth) {
+    deferredWrites.maxDepth = depth;
+  }
+
+  while (deferredWrites.head != deferredWrites.tail) {
+    __DMB();  // Read the entry only after seeing the index that published it
+    DeferredWrite& entry = deferredWrites.entries[deferredWrites.head % DEFERRED_WRITE_QUEUE_LEN];
+
+    // Flash writes block the loop for milliseconds; the RTP zero at envelope end must not
+    // wait behind them, so they stay queued (in order) until the envelope has ended
+    bool writesFlash = entry.target == DEFERRED_PATTERN_UPLOAD || entry.target == DEFERRED_BULK;
+    if (writesFlash && hapticDriver.rtpPlaying()) {
+      deferredWrites.heldForRtp++;
+      break;
+    }
+
+    // Backpressure for acks: a write whose ack would not fit waits (in order) for the links to
+    // drain, rather than having its ack dropped. Bounded, so a stalled link cannot hold the
+    // queue - and the disconnect events behind it - forever.
+    bool acknowledged = entry.target == DEFERRED_CALIBRATION || entry.target == DEFERRED_PATTERN_UPLOAD ||
+                        entry.target == DEFERRED_COMMAND || entry.target == DEFERRED_BULK;
+    if (acknowledged && !telemetryAckRoom()) {
+      if (!deferredWrites.ackHeld) {
+        deferredWrites.ackHeld = true;
+        deferredWrites.ackHeldSince = millis();
+      }
+      if (millis() - deferredWrites.ackHeldSince < TX_ACK_HOLD_MS) {
+        deferredWrites.heldForAck++;
+        break;
+      }
+    }
+    deferredWrites.ackHeld = false;
+
+    uint32_t start = micros();
+    uint32_t wait = start - entry.receivedUs;
+    if (wait > deferredWrites.waitMaxUs) {
+      deferredWrites.waitMaxUs = wait;
+    }
+
+    switch (entry.target) {
+      case DEFERRED_HAPTIC_CONTROL:
+        handleHapticControlWrite(entry.connHandle, entry.data, entry.len);
+        break;
+      case DEFERRED_ZONE_SETTINGS:
+        handleZoneSettingsWrite(entry.connHandle, entry.data, entry.len);
+        break;
+      case DEFERRED_CALIBRATION:
+        handleCalibrationWrite(entry.connHandle, entry.data, entry.len);
+        break;
+      case DEFERRED_AUDIO_CONTROL:
+        handleAudioControlWrite(entry.connHandle, entry.data, entry.len);
+        break;
+      case DEFERRED_PATTERN_UPLOAD:
+        handlePatternUploadWrite(entry.connHandle, entry.data, entry.len);
+        break;
+      case DEFERRED_COMMAND:
+        handleCommandWrite(entry.connHandle, entry.data, entry.len, entry.receivedUs);
+        break;
+      case DEFERRED_BULK:
+        handleBulkWrite(entry.connHandle, entry.data, entry.len);
+        break;
+      case DEFERRED_LINK_CONNECTED: {
+        ble_gap_addr_t peerAddr;
+        memcpy(&peerAddr, entry.data, sizeof(peerAddr));
+        handleLinkConnected(entry.connHandle, peerAddr);
+        break;
+      }
+      case DEFERRED_LINK_SECURED:
+        handleLinkSecured(entry.connHandle);
+        break;
+      case DEFERRED_LINK_DISCONNECTED:
+        handleLinkDisconnected(entry.connHandle, entry.data[0]);
+        break;
+    }
+
+    uint32_t run = micros() - start;
+    if (run > deferredWrites.runMaxUs) {
+      deferredWrites.runMaxUs = run;
+    }
+    deferredWrites.executed++;
+
+    __DMB();  // Done with the entry before handing the slot back
+    deferredWrites.head = deferredWrites.head + 1;
+  }
+}
+
+void printDeferredWriteStats() {
+  Serial.print("Deferred writes: ");
+  Serial.print(deferredWrites.executed);
+  Serial.print(" run | dropped ");
+  Serial.print(deferredWrites.dropped);
+  Serial.print(" | max depth ");
+  Serial.print(deferredWrites.maxDepth);
+  Serial.print(" | held for RTP ");
+  Serial.print(deferredWrites.heldForRtp);
+  Serial.print(" | held for ack room ");
+  Serial.println(deferredWrites.heldForAck);
+  if (deferredWrites.deferred > 0) {
+    Serial.print("  In callback: avg ");
+    Serial.print((uint32_t)(deferredWrites.callbackTotalUs / deferredWrites.deferred));
+    Serial.print("us | max ");
+    Serial.print(deferredWrites.callbackMaxUs);
+    Serial.print("us | wait for loop max ");
+    Serial.print(deferredWrites.waitMaxUs);
+    Serial.print("us | longest handler ");
+    Serial.print(deferredWrites.runMaxUs / 1000);
+    Serial.println("ms");
+  }
+}
+
+// ----------------------------------------------------------------------------
+// Batched TLV commands
+// ----------------------------------------------------------------------------
+
+// One write carries [seq] followed by [type][length][value] commands. The whole batch is
+// validated first; only if every command is acceptable are they run, in order, from the
+// deferred write queue in loop(). One ack notification reports the batch result and a
+// status per command.
+
+// Check one command against the device state the batch will have reached by then
+uint8_t validateCommand(uint8_t type, const uint8_t* value, uint8_t len, bool& zoneConfigured, uint16_t& spm) {
+  switch (type) {
+    case COMMAND_ZONE:
+      if (len < 6 || len > 8) return COMMAND_BAD_LENGTH;
+      spm = value[3] | (value[4] << 8);
+      if (spm == 0) return COMMAND_INVALID_VALUE;
+      if (len > 6 && value[6] != 0 && !findCustomPattern(value[6])) return COMMAND_INVALID_VALUE;
+      if (len > 7 && value[7] > PACING_TIMED) return COMMAND_INVALID_VALUE;
+      zoneConfigured = true;
+      return COMMAND_OK;
+
+    case COMMAND_THRESHOLD:
+      if (len != 2) return COMMAND_BAD_LENGTH;
+      if ((int16_t)(value[0] | (value[1] << 8)) <= 0) return COMMAND_INVALID_VALUE;
+      return COMMAND_OK;
+
+    case COMMAND_START:
+      if (len != 0) return COMMAND_BAD_LENGTH;
+      if (!zoneConfigured || spm == 0) return COMMAND_NOT_ALLOWED;
+      return COMMAND_OK;
+
+    case COMMAND_PLAY_CUE:
+      if (len < 1 || len > 2) return COMMAND_BAD_LENGTH;
+      if (value[0] == 0 || (value[0] >= CUSTOM_PATTERN_BASE && !findCustomPattern(value[0]))) return COMMAND_INVALID_VALUE;
+      return COMMAND_OK;
+
+    case COMMAND_HAPTIC:
+      if (len < 1 || len > 5) return COMMAND_BAD_LENGTH;
+      if (value[0] > CMD_CALIBRATE_ACTUATOR) return COMMAND_INVALID_VALUE;
+      if (value[0] == CMD_START_TRAINING && (!zoneConfigured || spm == 0)) return COMMAND_NOT_ALLOWED;
+      if (value[0] == CMD_STOP || value[0] == CMD_COMPLETE_TRAINING) zoneConfigured = false;
+      return COMMAND_OK;
+
+    case COMMAND_CALIBRATION:
+      if (len < 1 || len > 3) return COMMAND_BAD_LENGTH;
+      if (value[0] < CAL_CMD_START || value[0] > CAL_CMD_GET_STATUS) return COMMAND_INVALID_VALUE;
+      if (value[0] == CAL_CMD_SET_THRESHOLD && len != 3) return COMMAND_BAD_LENGTH;
+      return COMMAND_OK;
+
+    case COMMAND_AUDIO:
+      if (len < 1 || len > 2) return COMMAND_BAD_LENGTH;
+      return COMMAND_OK;
+
+    case COMMAND_PING:
+      if (len != 0) return COMMAND_BAD_LENGTH;
+      return COMMAND_OK;
+
+    default:
+      return COMMAND_UNKNOWN_TYPE;
+  }
+}
+
+void executeCommand(uint8_t type, const uint8_t* value, uint8_t len) {
+  switch (type) {
+    case COMMAND_ZONE:
+      applyZoneSettings(value, len);
+      break;
+
+    case COMMAND_THRESHOLD:
+      strokeDetection.threshold = (int16_t)(value[0] | (value[1] << 8)) / 100.0;
+      Serial.print("Threshold set to: ");
+      Serial.print(strokeDetection.threshold, 2);
+      Serial.println("g");
+      break;
+
+    case COMMAND_START:
+      startTraining();
+      break;
+
+    case COMMAND_PLAY_CUE:
+      playHapticPattern(value[0], len > 1 ? value[1] : 100, HAPTIC_PRIO_CONFIRM);
+      break;
+
+    case COMMAND_HAPTIC:
+      executeHapticCommand(value, len);
+      break;
+
+    case COMMAND_CALIBRATION:
+      executeCalibrationCommand(value, len);
+      break;
+
+    case COMMAND_AUDIO:
+      playAudioEvent(value[0], len > 1 ? value[1] : 80);
+      break;
+
+    case COMMAND_PING:
+      break;  // The ack is the response
+  }
+}
+
+// Newest first, so a sequence reused after a rejected batch finds the latest ack
+CommandAckRecord* findCommandAck(uint16_t conn_hdl, uint8_t sequence) {
+  for (uint8_t i = 1; i <= COMMAND_ACK_HISTORY; i++) {
+    CommandAckRecord& record = commandBatch.history[(commandBatch.historyNext + COMMAND_ACK_HISTORY - i) % COMMAND_ACK_HISTORY];
+    if (record.ackLen > 0 && record.connHandle == conn_hdl && record.ack[0] == sequence) {
+      return &record;
+    }
+  }
+  return NULL;
+}
+
+void queueCommandAck(const CommandAckRecord& record) {
+  uint8_t links = 0;
+  for (uint8_t i = 0; i < BLE_MAX_LINKS; i++) {
+    if (bleLinks[i].active && bleLinks[i].connHandle == record.connHandle) links |= (1 << i);
+  }
+  queueTelemetryAckTo(links, commandChar, record.ack, record.ackLen);
+}
+
+void sendCommandAck(uint16_t conn_hdl, uint8_t sequence, uint8_t result, const uint8_t* statuses, uint8_t count,
+                    uint32_t receivedUs) {
+  // Format: [seq][result][count][status x count]
+  CommandAckRecord& record = commandBatch.history[commandBatch.historyNext];
+  commandBatch.historyNext = (commandBatch.historyNext + 1) % COMMAND_ACK_HISTORY;
+  record.connHandle = conn_hdl;
+  record.ack[0] = sequence;
+  record.ack[1] = result;
+  record.ack[2] = count;
+  memcpy(record.ack + 3, statuses, count);
+  record.ackLen = 3 + count;
+  record.receivedUs = receivedUs;
+  record.timed = false;
+  queueCommandAck(record);
+}
+
+// Called when an ack notification is handed to the SoftDevice
+void noteCommandAckSent(uint16_t conn_hdl, uint8_t sequence) {
+  CommandAckRecord* record = findCommandAck(conn_hdl, sequence);
+  if (!record || record->timed) {
+    return;
+  }
+  record->timed = true;
+
+  uint32_t turnaround = micros() - record->receivedUs;
+  if (commandBatch.acksTimed == 0 || turnaround < commandBatch.ackMinUs) commandBatch.ackMinUs = turnaround;
+  if (turnaround > commandBatch.ackMaxUs) commandBatch.ackMaxUs = turnaround;
+  commandBatch.ackTotalUs += turnaround;
+  commandBatch.acksTimed++;
+}
+
+void handleCommandWrite(uint16_t conn_hdl, uint8_t* data, uint16_t len, uint32_t received) {
+  if (len < 1) return;
+  uint8_t sequence = data[0];
+  uint8_t statuses[COMMAND_BATCH_MAX] = {};
+
+  // Retransmission of a recent executed batch (its ack was lost) - repeat the ack, do not run it
+  // twice. Batches that did not run are simply evaluated again.
+  CommandAckRecord* previous = findCommandAck(conn_hdl, sequence);
+  if (previous && previous->ack[1] == BATCH_EXECUTED) {
+    commandBatch.duplicates++;
+    queueCommandAck(*previous);
+    return;
+  }
+
+  if (!acquireControl(conn_hdl)) {
+    sendCommandAck(conn_hdl, sequence, BATCH_NOT_CONTROLLER, statuses, 0, received);
+    return;
+  }
+
+  // Pass 1: framing and validation
+  const uint8_t* values[COMMAND_BATCH_MAX];
+  uint8_t types[COMMAND_BATCH_MAX];
+  uint8_t lengths[COMMAND_BATCH_MAX];
+  uint8_t count = 0;
+  uint16_t offset = 1;
+  bool valid = true;
+  bool zoneConfigured = trainingConfig.isActive;
+  uint16_t spm = trainingConfig.strokesPerMinute;
+
+  while (offset < len) {
+    if (count == COMMAND_BATCH_MAX || offset + 2 > len || offset + 2 + data[offset + 1] > len) {
+      Serial.println("ERROR: Malformed command batch");
+      commandBatch.rejected++;
+      sendCommandAck(conn_hdl, sequence, BATCH_MALFORMED, statuses, count, received);
+      return;
+    }
+    types[count] = data[offset];
+    lengths[count] = data[offset + 1];
+    values[count] = data + offset + 2;
+    statuses[count] = validateCommand(types[count], values[count], lengths[count], zoneConfigured, spm);
+    valid = valid && statuses[count] == COMMAND_OK;
+    offset += 2 + lengths[count];
+    count++;
+  }
+
+  if (!valid) {
+    for (uint8_t i = 0; i < count; i++) {
+      if (statuses[i] == COMMAND_OK) statuses[i] = COMMAND_SKIPPED;
+    }
+    Serial.println("Command batch rejected - nothing executed");
+    commandBatch.rejected++;
+    sendCommandAck(conn_hdl, sequence, BATCH_REJECTED, statuses, count, received);
+    return;
+  }
+
+  // Pass 2: run in order
+  Serial.print("Command batch ");
+  Serial.print(sequence);
+  Serial.print(": ");
+  Serial.print(count);
+  Serial.println(" command(s)");
+  for (uint8_t i = 0; i < count; i++) {
+    executeCommand(types[i], values[i], lengths[i]);
+  }
+
+  commandBatch.batches++;
+  commandBatch.commands += count;
+  sendCommandAck(conn_hdl, sequence, BATCH_EXECUTED, statuses, count, received);
+}
+
+// ============================================================================
+// BLE STATUS UPDATES
+// ============================================================================
+
+void updateDeviceStatus() {
+  // Format: [state(1)][current_stroke(2)][current_set(1)][battery(1)]
+  uint8_t status[5];
+  status[0] = trainingState.deviceState;
+  status[1] = trainingState.currentStroke & 0xFF;
+  status[2] = (trainingState.currentStroke >> 8) & 0xFF;
+  status[3] = trainingState.currentSet;
+  status[4] = trainingState.batteryLevel;
+
+  deviceStatusChar.write(status, 5);  // Reads always see the current value
+
+  statusPublisher.requests++;
+  if (trainingState.deviceState == STATE_TRAINING && Bluefruit.connected()) {
+    statusPublisher.trainingRequests++;
+  }
+
+  memcpy(statusPublisher.current, status, 5);
+  bool changed = false;
+  bool stateChanged = false;
+  for (uint8_t i = 0; i < BLE_MAX_LINKS; i++) {
+    const BleLink& link = bleLinks[i];
+    if (!link.active || link.statusPending) continue;
+    if (memcmp(status, link.statusSent, 5) != 0) changed = true;
+    if (status[0] != link.statusSent[0]) stateChanged = true;
+  }
+  if (!changed) {
+    statusPublisher.dirty = false;  // Changed back before it was published
+    return;
+  }
+
+  // State transitions are flushed immediately; counters and battery wait for the rate limit
+  if (stateChanged) {
+    publishDeviceStatus();
+  } else {
+    statusPublisher.dirty = true;
+  }
+}
+
+// Connection status is per link: every central is told its own MTU / data length / PHY
+void updateConnectionStatus() {
+  uint8_t status[7];
+  BleLink* first = NULL;
+  for (uint8_t i = 0; i < BLE_MAX_LINKS; i++) {
+    if (!bleLinks[i].active) continue;
+    bleLinks[i].connStatusPending = true;
+    if (!first) first = &bleLinks[i];
+  }
+
+  // Reads see the first link's values
+  encodeConnectionStatus(first, status);
+  connectionStatusChar.write(status, 7);
+}
+
+void encodeConnectionStatus(const BleLink* link, uint8_t* status) {
+  // Format: [connected(1)][rssi(1 signed)][mtu(2)][data_length(2)][phy(1)]
+  LinkState values = link ? link->link : LinkState{23, 27, BLE_GAP_PHY_1MBPS, 0, 0, 0, 0};
+  status[0] = Bluefruit.connected();  // Number of connected centrals
+  status[1] = 0;  // RSSI not easily accessible on nRF52, set to 0
+  status[2] = values.mtu & 0xFF;
+  status[3] = values.mtu >> 8;
+  status[4] = values.dataLength & 0xFF;
+  status[5] = values.dataLength >> 8;
+  status[6] = values.phy;
+}
+
+void encodeStateSnapshot(const BleLink* link, uint8_t* snapshot) {
+  // Format: [version(1)][firmware(1) major<<4 | minor][capabilities(1)][flags(1)]
+  //         [state(1)][current_stroke(2)][current_set(1)][battery(1)]
+  //         [total_strokes(2)][total_sets(1)][spm(2)][zone_color(1)][stroke_pattern(1)]
+  //         [threshold(2) g x 100][connected(1)][phy(1)][records_pending(1)][record_sequence(1)]
+  uint8_t flags = 0;
+  if (timeSync.synced) flags |= SNAPSHOT_FLAG_TIME_SYNCED;
+  if (link && controlArbiter.owner == link->connHandle) flags |= SNAPSHOT_FLAG_HAS_CONTROL;
+  if (link && link->bonded) flags |= SNAPSHOT_FLAG_BONDED;
+  for (uint8_t i = 0; i < CUSTOM_PATTERN_SLOTS; i++) {
+    if (patternLibrary.patterns[i].id != 0) flags |= SNAPSHOT_FLAG_CUSTOM_PATTERNS;
+  }
+  if (hapticLatency.magic == HAPTIC_LATENCY_MAGIC) flags |= SNAPSHOT_FLAG_LATENCY_PROFILE;
+  if (calibrationState.active) flags |= SNAPSHOT_FLAG_CALIBRATING;
+  if (trainingConfig.pacing == PACING_TIMED) flags |= SNAPSHOT_FLAG_TIMED_PACING;
+
+  int16_t threshold = (int16_t)(strokeDetection.threshold * 100.0);
+  uint8_t pending = link ? strokeTelemetry.count - link->strokeSent : 0;
+
+  snapshot[0] = SNAPSHOT_VERSION;
+  snapshot[1] = (FIRMWARE_VERSION_MAJOR << 4) | (FIRMWARE_VERSION_MINOR & 0x0F);
+  snapshot[2] = SNAPSHOT_CAP_COMMAND | SNAPSHOT_CAP_TIME_SYNC | SNAPSHOT_CAP_STROKE_RECORDS |
+                SNAPSHOT_CAP_PATTERN_UPLOAD | SNAPSHOT_CAP_BULK | SNAPSHOT_CAP_AUDIO;
+  snapshot[3] = flags;
+  snapshot[4] = trainingState.deviceState;
+  snapshot[5] = trainingState.currentStroke & 0xFF;
+  snapshot[6] = (trainingState.currentStroke >> 8) & 0xFF;
+  snapshot[7] = trainingState.currentSet;
+  snapshot[8] = trainingState.batteryLevel;
+  snapshot[9] = trainingConfig.totalStrokes & 0xFF;
+  snapshot[10] = trainingConfig.totalStrokes >> 8;
+  snapshot[11] = trainingConfig.totalSets;
+  snapshot[12] = trainingConfig.strokesPerMinute & 0xFF;
+  snapshot[13] = trainingConfig.strokesPerMinute >> 8;
+  snapshot[14] = trainingConfig.zoneColor;
+  snapshot[15] = trainingConfig.strokePattern;
+  snapshot[16] = threshold & 0xFF;
+  snapshot[17] = (threshold >> 8) & 0xFF;
+  snapshot[18] = Bluefruit.connected();
+  snapshot[19] = link ? link->link.phy : BLE_GAP_PHY_1MBPS;
+  snapshot[20] = pending;
+  snapshot[21] = link ? link->strokeSequence : 0;
+}
+
+// Read authorization runs in the BLE task: the snapshot is encoded for the reading central
+// and returned in the same reply, so one round trip gives the app everything it needs
+void onSnapshotRead(uint16_t conn_hdl, BLECharacteristic* chr, ble_gatts_evt_read_t* request) {
+  BleLink* link = findLink(conn_hdl);
+  uint8_t encoded[SNAPSHOT_LEN];
+  uint8_t* snapshot = link ? link->snapshot : encoded;
+
+  // A central with a small MTU reads in parts (offset > 0). Every part is served from the
+  // snapshot encoded for the first one, so the parts belong together.
+  uint16_t offset = request->offset;
+  if (offset == 0 || !link) {
+    encodeStateSnapshot(link, snapshot);
+  }
+  if (offset == 0) {
+    snapshotChar.write(snapshot, SNAPSHOT_LEN);  // Plain reads outside the callback see it too
+  }
+
+  ble_gatts_rw_authorize_reply_params_t reply = {};
+  reply.type = BLE_GATTS_AUTHORIZE_TYPE_READ;
+  if (offset > SNAPSHOT_LEN) {
+    reply.params.read.gatt_status = BLE_GATT_STATUS_ATTERR_INVALID_OFFSET;
+  } else {
+    reply.params.read.gatt_status = BLE_GATT_STATUS_SUCCESS;
+    reply.params.read.update = 1;
+    reply.params.read.offset = offset;
+    reply.params.read.len = SNAPSHOT_LEN - offset;
+    reply.params.read.p_data = snapshot + offset;
+  }
+  sd_ble_gatts_rw_authorize_reply(conn_hdl, &reply);
+
+  snapshotStats.reads++;
+  if (link && !link->snapshotRead) {
+    link->snapshotRead = true;
+    uint32_t readyMs = millis() - link->params.connectedAt;
+    snapshotStats.readyLastMs = readyMs;
+    snapshotStats.readySumMs += readyMs;
+    if (snapshotStats.readyCount == 0 || readyMs < snapshotStats.readyMinMs) snapshotStats.readyMinMs = readyMs;
+    if (readyMs > snapshotStats.readyMaxMs) snapshotStats.readyMaxMs = readyMs;
+    snapshotStats.readyCount++;
+  }
+}
+
+// Ask each central for the profile matching the current state. The central may grant
+// different values; serviceLinkMonitor() logs what is actually in effect.
+void serviceConnParams() {
+  bool session = trainingState.deviceState == STATE_TRAINING ||
+                 trainingState.deviceState == STATE_CALIBRATING;
+
+  for (uint8_t i = 0; i < BLE_MAX_LINKS; i++) {
+    BleLink& link = bleLinks[i];
+    if (!link.active || millis() - link.params.connectedAt < CONN_SETTLE_MS) {
+      continue;
+    }
+
+    bool active = session || (long)(link.params.streamUntil - millis()) > 0;
+    uint8_t wanted = active ? CONN_PROFILE_ACTIVE : CONN_PROFILE_IDLE;
+    if (wanted == link.params.profile) {
+      continue;
+    }
+
+    BLEConnection* connection = Bluefruit.Connection(link.connHandle);
+    if (!connection) continue;
+
+    uint16_t interval = active ? CONN_ACTIVE_INTERVAL : CONN_IDLE_INTERVAL;
+    uint16_t latency = active ? CONN_ACTIVE_LATENCY : CONN_IDLE_LATENCY;
+    if (!connection->requestConnectionParameter(interval, latency, CONN_SUPERVISION_TIMEOUT)) {
+      continue;  // Retried on the next pass
+    }
+
+    link.params.profile = wanted;
+    link.params.requests++;
+    Serial.print("Link ");
+    Serial.print(i);
+    Serial.print(": requesting ");
+    Serial.print(active ? "active" : "idle");
+    Serial.print(" connection profile: interval ");
+    Serial.print(interval * 1.25f, 2);
+    Serial.print("ms | latency ");
+    Serial.println(latency);
+  }
+}
+
+// Keep the active profile on this link while a bulk transfer (e.g. pattern upload) is in progress
+void noteLinkStreaming(uint16_t connHandle) {
+  BleLink* link = findLink(connHandle);
+  if (link) {
+    link->params.streamUntil = millis() + CONN_STREAM_HOLD_MS;
+  }
+}
+
+// Queue the current status for the given links. Links still waiting on the slot get the
+// newer value as well, so their statusSent follows.
+void queueDeviceStatus(uint8_t links) {
+  links |= telemetryTx.slots[TX_SLOT_DEVICE_STATUS].pendingLinks;
+  for (uint8_t i = 0; i < BLE_MAX_LINKS; i++) {
+    if (links & (1 << i)) {
+      memcpy(bleLinks[i].statusSent, statusPublisher.current, 5);
+    }
+  }
+  queueTelemetryValueTo(links, TX_SLOT_DEVICE_STATUS, deviceStatusChar, statusPublisher.current, 5);
+}
+
+void publishDeviceStatus() {
+  uint8_t links = 0;
+  for (uint8_t i = 0; i < BLE_MAX_LINKS; i++) {
+    const BleLink& link = bleLinks[i];
+    if (link.active && !link.statusPending && memcmp(statusPublisher.current, link.statusSent, 5) != 0) {
+      links |= (1 << i);
+    }
+  }
+  queueDeviceStatus(links);
+  statusPublisher.dirty = false;
+  statusPublisher.lastPublish = millis();
+  statusPublisher.published++;
+  if (trainingState.deviceState == STATE_TRAINING && Bluefruit.connected()) {
+    statusPublisher.trainingPublished++;
+  }
+}
+
+// Called from loop(): publish a rate-limited change once the interval has passed
+void serviceStatusPublisher() {
+  unsigned long now = millis();
+  if (Bluefruit.connected() && trainingState.deviceState == STATE_TRAINING) {
+    statusPublisher.trainingMs += now - statusPublisher.lastTick;
+  }
+  statusPublisher.lastTick = now;
+
+  if (statusPublisher.dirty && now - statusPublisher.lastPublish >= STATUS_MIN_INTERVAL_MS) {
+    publishDeviceStatus();
+  }
+
+  // A new central is sent the current status once it has subscribed (a bonded one's CCCD
+  // is restored only after encryption); the other links are not touched
+  for (uint8_t i = 0; i < BLE_MAX_LINKS; i++) {
+    BleLink& link = bleLinks[i];
+    if (!link.active || !link.statusPending) continue;
+    if (deviceStatusChar.notifyEnabled(link.connHandle)) {
+      link.statusPending = false;
+      queueDeviceStatus(1 << i);
+    } else if (now - link.params.connectedAt >= RECONNECT_SUBSCRIBE_GRACE_MS) {
+      link.statusPending = false;  // Not subscribed - it reads the value when it wants it
+      memcpy(link.statusSent, statusPublisher.current, 5);
+    }
+  }
+}
+
+void printStatusPublisherStats() {
+  Serial.print("Status requests / published: ");
+  Serial.print(statusPublisher.requests);
+  Serial.print(" / ");
+  Serial.println(statusPublisher.published);
+  if (statusPublisher.trainingMs >= 1000) {
+    float minutes = statusPublisher.trainingMs / 60000.0f;
+    Serial.print("Status notifications per training minute: before ");
+    Serial.print(statusPublisher.trainingRequests / minutes, 1);
+    Serial.print(" | after ");
+    Serial.println(statusPublisher.trainingPublished / minutes, 1);
+  }
+}
+
+// ----------------------------------------------------------------------------
+// Session reconnect
+// ----------------------------------------------------------------------------
+
+// Called from loop(): directed advertising to a dropped, bonded session central, then back to
+// normal advertising; stop an abandoned session after SESSION_ORPHAN_TIMEOUT_MS
+void serviceReconnect() {
+  if (reconnectState.directedPending) {
+    reconnectState.directedPending = false;
+
+    // Bluefruit restarted undirected advertising on disconnect - replace it with high duty
+    // cycle directed advertising (up to 1.28s, only the session central can connect).
+    // Phones use rotating private addresses: target the identity address and register the
+    // IRK so the SoftDevice addresses the central's current private address.
+    Bluefruit.Advertising.stop();
+    const ble_gap_id_key_t* identities[1] = {&reconnectState.peerId};
+    sd_ble_gap_device_identities_set(identities, NULL, 1);
+
+    ble_gap_adv_params_t params = {};
+    params.properties.type = BLE_GAP_ADV_TYPE_CONNECTABLE_NONSCANNABLE_DIRECTED_HIGH_DUTY_CYCLE;
+    params.p_peer_addr = &reconnectState.peerId.id_addr_info;
+    params.filter_policy = BLE_GAP_ADV_FP_ANY;
+    params.primary_phy = BLE_GAP_PHY_AUTO;
+
+    uint8_t handle = ADV_SET_HANDLE;
+    reconnectState.advertisingEnded = false;
+    if (sd_ble_gap_adv_set_configure(&handle, NULL, &params) == NRF_SUCCESS &&
+        sd_ble_gap_adv_start(handle, BLE_CONN_CFG_TAG_PERIPHERAL) == NRF_SUCCESS) {
+      reconnectState.directedActive = true;
+      Serial.println("Directed advertising to the session central");
+    } else {
+      Bluefruit.Advertising.start(0);
+    }
+  }
+
+  // Directed advertising timed out (or the central connected) - resume normal advertising
+  if (reconnectState.advertisingEnded) {
+    reconnectState.advertisingEnded = false;
+    if (reconnectState.directedActive) {
+      reconnectState.directedActive = false;
+      if (Bluefruit.connected() < BLE_MAX_LINKS) {
+        Bluefruit.Advertising.start(0);
+      }
+    }
+  }
+
+  if (reconnectState.awaiting && Bluefruit.connected() == 0 &&
+      millis() - reconnectState.disconnectedAt >= SESSION_ORPHAN_TIMEOUT_MS) {
+    reconnectState.awaiting = false;
+    if (trainingState.deviceState == STATE_TRAINING || trainingState.deviceState == STATE_PAUSED) {
+      Serial.println("No central for 30 minutes - stopping session");
+      stopTraining();
+    }
+  }
+}
+
+// Callback task: resumeSessionCentral() rebases stroke offsets that serviceTelemetryTx()
+// also rebases, so the identity check and resume are left to loop()
+void onBLESecured(uint16_t conn_handle) {
+  uint8_t none = 0;
+  deferLinkEvent(DEFERRED_LINK_SECURED, conn_handle, &none, 0);
+}
+
+void handleLinkSecured(uint16_t conn_handle) {
+  BLEConnection* connection = Bluefruit.Connection(conn_handle);
+  BleLink* link = findLink(conn_handle);
+  bond_keys_t keys;
+  if (connection && link && connection->bonded() && connection->loadBondKey(&keys)) {
+    link->bonded = true;
+    link->peerId = keys.peer_id;
+    Serial.print("Link encrypted (bonded), connection ");
+    Serial.println(conn_handle);
+
+    // Same bond identity as the dropped session central, whatever address it connected from
+    if (reconnectState.awaiting && reconnectState.bonded &&
+        memcmp(keys.peer_id.id_info.irk, reconnectState.peerId.id_info.irk, sizeof(ble_gap_irk_t)) == 0 &&
+        memcmp(keys.peer_id.id_addr_info.addr, reconnectState.peerId.id_addr_info.addr, BLE_GAP_ADDR_LEN) == 0) {
+      resumeSessionCentral(*link);
+    }
+  }
+}
+
+// The session central is back: it resumes control and gets the records it missed, in order
+void resumeSessionCentral(BleLink& link) {
+  reconnectState.awaiting = false;
+  reconnectState.reconnects++;
+  reconnectState.recordsReplayed += strokeTelemetry.count - reconnectState.strokeSent;
+  link.strokeSent = reconnectState.strokeSent;
+  controlArbiter.owner = link.connHandle;
+  controlArbiter.lastCommand = millis();
+  Serial.print("Session central reconnected after ");
+  Serial.print(millis() - reconnectState.disconnectedAt);
+  Serial.print("ms - replaying ");
+  Serial.print(strokeTelemetry.count - reconnectState.strokeSent);
+  Serial.println(" stroke records");
+}
+
+// ----------------------------------------------------------------------------
+// Advertised status
+// ----------------------------------------------------------------------------
+
+void encodeAdvertisingStatus(uint8_t* status) {
+  // Format: [state(1)][battery(1)][current_stroke(2)][current_set(1)][version(1) major<<4 | minor]
+  status[0] = trainingState.deviceState;
+  status[1] = trainingState.batteryLevel;
+  status[2] = trainingState.currentStroke & 0xFF;
+  status[3] = (trainingState.currentStroke >> 8) & 0xFF;
+  status[4] = trainingState.currentSet;
+  status[5] = (FIRMWARE_VERSION_MAJOR << 4) | (FIRMWARE_VERSION_MINOR & 0x0F);
+}
+
+// Bluefruit's own copy, used whenever advertising is (re)started
+void buildAdvertisingData(const uint8_t* status) {
+  uint8_t manufacturer[2 + ADV_STATUS_LEN];
+  manufacturer[0] = ADV_COMPANY_ID & 0xFF;
+  manufacturer[1] = ADV_COMPANY_ID >> 8;
+  memcpy(manufacturer + 2, status, ADV_STATUS_LEN);
+
+  Bluefruit.Advertising.clearData();
+  Bluefruit.Advertising.addFlags(BLE_GAP_ADV_FLAGS_LE_ONLY_GENERAL_DISC_MODE);
+  Bluefruit.Advertising.addService(oroHapticService);
+  Bluefruit.Advertising.addManufacturerData(manufacturer, sizeof(manufacturer));
+}
+
+// Overwrite the status block inside an encoded advertising payload (our manufacturer data AD)
+bool patchAdvertisingStatus(uint8_t* data, uint8_t len, const uint8_t* status) {
+  uint8_t pos = 0;
+  while (pos + 1 < len && data[pos] > 0) {
+    uint8_t fieldLen = data[pos];  // Type + value
+    if (data[pos + 1] == BLE_GAP_AD_TYPE_MANUFACTURER_SPECIFIC_DATA && fieldLen == 3 + ADV_STATUS_LEN &&
+        pos + 1 + fieldLen <= len && data[pos + 2] == (ADV_COMPANY_ID & 0xFF) && data[pos + 3] == (ADV_COMPANY_ID >> 8)) {
+      memcpy(data + pos + 4, status, ADV_STATUS_LEN);
+      return true;
+    }
+    pos += 1 + fieldLen;
+  }
+  return false;
+}
+
+// Called from loop(): keep the advertised block current. While advertising, the new data is
+// handed to the SoftDevice in place (no stop/start, so scanners never miss the device).
+void serviceAdvertisingStatus() {
+  uint8_t status[ADV_STATUS_LEN];
+  encodeAdvertisingStatus(status);
+  if (memcmp(status, advertisingStatus.advertised, ADV_STATUS_LEN) == 0) {
+    return;
+  }
+  bool stateChanged = status[0] != advertisingStatus.advertised[0];
+  if (!stateChanged && millis() - advertisingStatus.lastUpdate < ADV_STATUS_MIN_INTERVAL_MS) {
+    return;
+  }
+
+  memcpy(advertisingStatus.advertised, status, ADV_STATUS_LEN);
+  advertisingStatus.lastUpdate = millis();
+  if (!Bluefruit.Advertising.isRunning()) {
+    buildAdvertisingData(status);  // Nothing reads Bluefruit's copy; picked up by the next start()
+    return;
+  }
+
+  // The SoftDevice may still be reading Bluefruit's copy (right after start()) or the pair
+  // handed over last, so the new payload is built in the other pair: a copy with the status
+  // bytes patched in place
+  uint8_t next = advertisingStatus.buffer ^ 1;
+  uint8_t advLen = Bluefruit.Advertising.count();
+  uint8_t scanLen = Bluefruit.ScanResponse.count();
+  memcpy(advertisingStatus.advData[next], Bluefruit.Advertising.getData(), advLen);
+  memcpy(advertisingStatus.scanData[next], Bluefruit.ScanResponse.getData(), scanLen);
+  if (!patchAdvertisingStatus(advertisingStatus.advData[next], advLen, status)) {
+    advertisingStatus.failures++;
+    return;
+  }
+
+  ble_gap_adv_data_t data;
+  data.adv_data.p_data = advertisingStatus.advData[next];
+  data.adv_data.len = advLen;
+  data.scan_rsp_data.p_data = advertisingStatus.scanData[next];
+  data.scan_rsp_data.len = scanLen;
+
+  uint8_t handle = ADV_SET_HANDLE;
+  if (sd_ble_gap_adv_set_configure(&handle, &data, NULL) == NRF_SUCCESS) {
+    advertisingStatus.buffer = next;
+    advertisingStatus.updates++;
+    buildAdvertisingData(status);  // The SoftDevice now reads advData[next]; refresh Bluefruit's copy
+  } else {
+    advertisingStatus.failures++;
+  }
+}
+
+// ----------------------------------------------------------------------------
+// Peripheral links
+// ----------------------------------------------------------------------------
+
+BleLink* findLink(uint16_t connHandle) {
+  for (uint8_t i = 0; i < BLE_MAX_LINKS; i++) {
+    if (bleLinks[i].active && bleLinks[i].connHandle == connHandle) {
+      return &bleLinks[i];
+    }
+  }
+  return NULL;
+}
+
+uint8_t activeLinkMask() {
+  uint8_t mask = 0;
+  for (uint8_t i = 0; i < BLE_MAX_LINKS; i++) {
+    if (bleLinks[i].active) mask |= (1 << i);
+  }
+  return mask;
+}
+
+bool anyLinkSubscribed(BLECharacteristic& chr) {
+  for (uint8_t i = 0; i < BLE_MAX_LINKS; i++) {
+    if (bleLinks[i].active && chr.notifyEnabled(bleLinks[i].connHandle)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// Accept a command from this central if it holds control, nobody does, or the holder has
+// been idle past the lease outside a session. Returns false if the write must be ignored.
+bool acquireControl(uint16_t connHandle) {
+  BleLink* link = findLink(connHandle);
+  if (link) {
+    link->writes++;
+  }
+
+  bool session = trainingState.deviceState == STATE_TRAINING ||
+                 trainingState.deviceState == STATE_PAUSED ||
+                 trainingState.deviceState == STATE_CALIBRATING;
+  bool ownerConnected = findLink(controlArbiter.owner) != NULL;
+
+  if (!ownerConnected || controlArbiter.owner == connHandle ||
+      (!session && millis() - controlArbiter.lastCommand >= CONTROL_LEASE_MS)) {
+    if (controlArbiter.owner != connHandle) {
+      Serial.print("Control granted to connection ");
+      Serial.println(connHandle);
+    }
+    controlArbiter.owner = connHandle;
+    controlArbiter.lastCommand = millis();
+    return true;
+  }
+
+  if (link) {
+    link->rejectedWrites++;
+  }
+  Serial.println("Command ignored: another central has control");
+  return false;
+}
+
+void printLinkStats() {
+  Serial.println("\n=== BLE LINKS ===");
+  for (uint8_t i = 0; i < BLE_MAX_LINKS; i++) {
+    const BleLink& link = bleLinks[i];
+    Serial.print("Link ");
+    Serial.print(i);
+    if (!link.active) {
+      Serial.println(": free");
+      continue;
+    }
+    float seconds = max(1UL, millis() - link.params.connectedAt) / 1000.0f;
+    Serial.print(link.connHandle == controlArbiter.owner ? " (controller)" : "");
+    Serial.print(": handle ");
+    Serial.print(link.connHandle);
+    Serial.print(" | MTU ");
+    Serial.print(link.link.mtu);
+    Serial.print(" | PHY ");
+    Serial.print(link.link.phy == BLE_GAP_PHY_2MBPS ? "2M" : "1M");
+    Serial.print(" | interval ");
+    Serial.print(link.link.interval * 1.25f, 2);
+    Serial.println("ms");
+    Serial.print("  notify ");
+    Serial.print(link.notifications);
+    Serial.print(" (");
+    Serial.print(link.bytes / seconds, 1);
+    Serial.print(" B/s) | stalls ");
+    Serial.print(link.stalls);
+    Serial.print(" | credits ");
+    Serial.print(link.credits);
+    Serial.print(" | writes ");
+    Serial.print(link.writes);
+    Serial.print(" | rejected ");
+    Serial.println(link.rejectedWrites);
+  }
+  Serial.print("Command batches: ");
+  Serial.print(commandBatch.batches);
+  Serial.print(" (");
+  Serial.print(commandBatch.commands);
+  Serial.print(" commands) | rejected ");
+  Serial.print(commandBatch.rejected);
+  Serial.print(" | retried ");
+  Serial.println(commandBatch.duplicates);
+  if (commandBatch.acksTimed > 0) {
+    Serial.print("Command ack turnaround: min ");
+    Serial.print(commandBatch.ackMinUs);
+    Serial.print("us | avg ");
+    Serial.print((uint32_t)(commandBatch.ackTotalUs / commandBatch.acksTimed));
+    Serial.print("us | max ");
+    Serial.print(commandBatch.ackMaxUs);
+    Serial.println("us (write received -> ack queued to the radio)");
+  }
+  printDeferredWriteStats();
+  if (snapshotStats.readyCount > 0) {
+    Serial.print("Time to ready (connect -> snapshot read): last ");
+    Serial.print(snapshotStats.readyLastMs);
+    Serial.print("ms | min ");
+    Serial.print(snapshotStats.readyMinMs);
+    Serial.print("ms | avg ");
+    Serial.print(snapshotStats.readySumMs / snapshotStats.readyCount);
+    Serial.print("ms | max ");
+    Serial.print(snapshotStats.readyMaxMs);
+    Serial.print("ms | ");
+    Serial.print(snapshotStats.reads);
+    Serial.println(" reads");
+  }
+  Serial.print("Session dropouts: ");
+  Serial.print(reconnectState.dropouts);
+  Serial.print(" | reconnects ");
+  Serial.print(reconnectState.reconnects);
+  Serial.print(" | records replayed ");
+  Serial.print(reconnectState.recordsReplayed);
+  Serial.println(reconnectState.awaiting ? " | waiting for session central" : "");
+  Serial.print("Advertised status updates: ");
+  Serial.print(advertisingStatus.updates);
+  Serial.print(" | failed ");
+  Serial.println(advertisingStatus.failures);
+}
+
+// ----------------------------------------------------------------------------
+// Connection-event aligned TX
+// ----------------------------------------------------------------------------
+
+// The radio notification fires RADIO_NOTIFICATION_LEAD_US before every radio event (each
+// connection event of every link, and advertising events). Instead of handing telemetry to
+// the SoftDevice as soon as it is produced - where it waits for the next event anyway -
+// loop() keeps coalescing the latest-value slots until the notification, so each event
+// carries the latest values. Acks and other one-shot events are not held.
+
+extern "C" void SWI1_EGU1_IRQHandler(void) {
+  radioTiming.lastActiveUs = micros();
+  radioTiming.notifications++;
+  radioTiming.windowPending = true;
+}
+
+// Runs after Bluefruit.begin(): while the SoftDevice is enabled it owns the NVIC, so the
+// interrupt is set up through its sd_nvic_* calls
+void initializeRadioNotification() {
+  if (sd_nvic_ClearPendingIRQ(SWI1_EGU1_IRQn) != NRF_SUCCESS ||
+      sd_nvic_SetPriority(SWI1_EGU1_IRQn, RADIO_NOTIFICATION_IRQ_PRIORITY) != NRF_SUCCESS ||
+      sd_nvic_EnableIRQ(SWI1_EGU1_IRQn) != NRF_SUCCESS) {
+    radioTiming.aligned = false;
+    Serial.println("WARNING: Radio notification IRQ unavailable - telemetry sent unaligned");
+    return;
+  }
+  if (sd_radio_notification_cfg_set(NRF_RADIO_NOTIFICATION_TYPE_INT_ON_ACTIVE,
+                                    NRF_RADIO_NOTIFICATION_DISTANCE_1740US) != NRF_SUCCESS) {
+    radioTiming.aligned = false;
+    Serial.println("WARNING: Radio notification unavailable - telemetry sent unaligned");
+  }
+}
+
+// True when queued telemetry should be handed to the SoftDevice now
+bool telemetryTxWindowOpen() {
+  if (radioTiming.windowPending) {
+    radioTiming.windowPending = false;
+    radioTiming.lastWindowUs = micros();
+    radioTiming.windows++;
+    return true;
+  }
+  if (!radioTiming.aligned) {
+    return true;
+  }
+
+  // Notifications only come for events that take place: a link with slave latency skips
+  // events while it has nothing queued, so never wait for one there
+  uint16_t interval = 0;
+  for (uint8_t i = 0; i < BLE_MAX_LINKS; i++) {
+    const BleLink& link = bleLinks[i];
+    if (!link.active) continue;
+    if (link.link.latency > 0 || link.link.interval == 0) {
+      return true;
+    }
+    interval = max(interval, link.link.interval);
+  }
+  if (interval == 0) {
+    return true;  // No links
+  }
+
+  // Notification missed (loop busy, or it fired while nothing was queued)
+  if (micros() - radioTiming.lastWindowUs > interval * 1250UL + RADIO_TX_HOLD_SLACK_US) {
+    radioTiming.lastWindowUs = micros();
+    radioTiming.forced++;
+    return true;
+  }
+  return false;
+}
+
+// A stroke record was handed to the SoftDevice; it goes on air at the next radio event
+void noteRecordHandover(uint32_t createdUs) {
+  uint32_t now = micros();
+  if (radioTiming.pendingRecords == 0) {
+    radioTiming.pendingAnchorUs = now;
+    radioTiming.pendingAgeSumUs = 0;
+    radioTiming.pendingAgeMaxUs = INT32_MIN;
+    radioTiming.pendingNotifications = radioTiming.notifications;
+  }
+  int32_t age = (int32_t)(radioTiming.pendingAnchorUs - createdUs);
+  radioTiming.pendingAgeSumUs += age;
+  radioTiming.pendingAgeMaxUs = max(radioTiming.pendingAgeMaxUs, age);
+  radioTiming.pendingRecords++;
+}
+
+// Close the measurement at the first notification after the hand-over: that event (starting
+// LEAD_US after the notification) is the earliest that can carry the records. With a free
+// link, advertising events also notify, so the estimate can come out slightly low.
+void serviceRadioLatency() {
+  if (radioTiming.pendingRecords == 0 || radioTiming.notifications == radioTiming.pendingNotifications) {
+    return;
+  }
+
+  uint32_t active = radioTiming.lastActiveUs;
+  if ((int32_t)(active - radioTiming.pendingAnchorUs) < 0) {
+    return;  // Notification belongs to an event before the hand-over
+  }
+  int64_t toAir = (int64_t)(active - radioTiming.pendingAnchorUs) + RADIO_NOTIFICATION_LEAD_US;
+  uint32_t average = (uint32_t)((radioTiming.pendingAgeSumUs + toAir * radioTiming.pendingRecords) / radioTiming.pendingRecords);
+  uint32_t worst = (uint32_t)(radioTiming.pendingAgeMaxUs + toAir);
+
+  if (radioTiming.latencyCount == 0 || average < radioTiming.latencyMinUs) radioTiming.latencyMinUs = average;
+  if (worst > radioTiming.latencyMaxUs) radioTiming.latencyMaxUs = worst;
+  radioTiming.latencySumUs += (uint64_t)average * radioTiming.pendingRecords;
+  radioTiming.latencyCount += radioTiming.pendingRecords;
+  radioTiming.pendingRecords = 0;
+}
+
+void printRadioTiming() {
+  Serial.println("\n=== CONNECTION-EVENT ALIGNED TX ===");
+  Serial.print("Alignment:          ");
+  Serial.println(radioTiming.aligned ? "on" : "off");
+  Serial.print("Radio notifications: ");
+  Serial.println(radioTiming.notifications);
+  Serial.print("Hand-overs:          ");
+  Serial.print(radioTiming.windows);
+  Serial.print(" at notification | ");
+  Serial.print(radioTiming.forced);
+  Serial.println(" forced");
+  if (radioTiming.latencyCount > 0) {
+    Serial.print("Stroke record sample-to-air: avg ");
+    Serial.print((uint32_t)(radioTiming.latencySumUs / radioTiming.latencyCount));
+    Serial.print("us | min ");
+    Serial.print(radioTiming.latencyMinUs);
+    Serial.print("us | max ");
+    Serial.print(radioTiming.latencyMaxUs);
+    Serial.print("us (");
+    Serial.print(radioTiming.latencyCount);
+    Serial.println(" records)");
+  }
+}
+
+void resetRadioLatency() {
+  radioTiming.latencyCount = 0;
+  radioTiming.latencySumUs = 0;
+  radioTiming.latencyMinUs = 0;
+  radioTiming.latencyMaxUs = 0;
+  radioTiming.pendingRecords = 0;
+}
+
+// ----------------------------------------------------------------------------
+// Telemetry TX queue
+// ----------------------------------------------------------------------------
+
+// Queue the latest value of a status characteristic (replaces an unsent older value)
+void queueTelemetryValue(TelemetrySlot slot, BLECharacteristic& chr, const uint8_t* data, uint8_t len) {
+  queueTelemetryValueTo(activeLinkMask(), slot, chr, data, len);
+}
+
+// The same, for a subset of links (any link still waiting on the slot should be included)
+void queueTelemetryValueTo(uint8_t links, TelemetrySlot slot, BLECharacteristic& chr, const uint8_t* data, uint8_t len) {
+  links &= activeLinkMask();
+  if (!links) return;
+
+  TelemetryValue& value = telemetryTx.slots[slot];
+  if (value.pendingLinks) {
+    telemetryTx.coalesced++;
+  }
+  value.chr = &chr;
+  value.len = min(len, (uint8_t)TX_MAX_VALUE_LEN);
+  memcpy(value.data, data, value.len);
+  value.pendingLinks = links;
+}
+
+// Queue a one-shot notification; events are sent in order and never coalesced or evicted.
+// Plain events may only fill the FIFO up to TX_EVENT_ACK_RESERVE; beyond that the new one is
+// refused (legacy stroke events and sync results are best effort).
+void queueTelemetryEvent(BLECharacteristic& chr, const uint8_t* data, uint8_t len) {
+  queueTelemetryEventTo(activeLinkMask(), chr, data, len);
+}
+
+// The same, for a subset of links
+void queueTelemetryEventTo(uint8_t links, BLECharacteristic& chr, const uint8_t* data, uint8_t len) {
+  if (!enqueueTelemetryEvent(links, chr, data, len, TX_EVENT_QUEUE_LEN - TX_EVENT_ACK_RESERVE)) {
+    telemetryTx.eventDrops++;
+  }
+}
+
+// Acks a central waits for (command batch, pattern upload, calibration, bulk END) may use the
+// whole FIFO. Writes that produce one are held until there is room (telemetryAckRoom), so
+// this only fails when a link has not drained for TX_ACK_HOLD_MS.
+bool queueTelemetryAck(BLECharacteristic& chr, const uint8_t* data, uint8_t len) {
+  return queueTelemetryAckTo(activeLinkMask(), chr, data, len);
+}
+
+bool queueTelemetryAckTo(uint8_t links, BLECharacteristic& chr, const uint8_t* data, uint8_t len) {
+  if (!enqueueTelemetryEvent(links, chr, data, len, TX_EVENT_QUEUE_LEN)) {
+    telemetryTx.ackDrops++;
+    return false;
+  }
+  return true;
+}
+
+bool telemetryAckRoom() {
+  return telemetryTx.eventCount < TX_EVENT_QUEUE_LEN;
+}
+
+bool enqueueTelemetryEvent(uint8_t links, BLECharacteristic& chr, const uint8_t* data, uint8_t len, uint8_t limit) {
+  links &= activeLinkMask();
+  if (!links) return true;  // Nobody to tell
+  if (telemetryTx.eventCount >= limit) {
+    return false;
+  }
+
+  TelemetryValue& event = telemetryTx.events[(telemetryTx.eventHead + telemetryTx.eventCount) % TX_EVENT_QUEUE_LEN];
+  event.chr = &chr;
+  event.len = min(len, (uint8_t)TX_MAX_VALUE_LEN);
+  memcpy(event.data, data, event.len);
+  event.pendingLinks = links;
+  telemetryTx.eventCount++;
+  if (telemetryTx.eventCount > telemetryTx.maxEventDepth) {
+    telemetryTx.maxEventDepth = telemetryTx.eventCount;
+  }
+  return true;
+}
+
+// Notify only when a SoftDevice buffer is free, so notify() never blocks or fails for lack of one
+bool sendTelemetry(BleLink& link, BLECharacteristic& chr, const uint8_t* data, uint16_t len) {
+  if (link.credits == 0) {
+    return false;
+  }
+  if (!chr.notify(link.connHandle, data, len)) {
+    telemetryTx.failed++;
+    return false;
+  }
+  link.credits--;
+  link.notifications++;
+  link.bytes += len;
+  telemetryTx.sent++;
+  return true;
+}
+
+// Send one queued value to one link. Returns false if the link is out of credits.
+bool sendTelemetryValue(BleLink& link, uint8_t bit, TelemetryValue& value) {
+  if (!(value.pendingLinks & bit)) {
+    return true;
+  }
+  if (value.chr->notifyEnabled(link.connHandle)) {
+    if (!sendTelemetry(link, *value.chr, value.data, value.len)) {
+      return false;
+    }
+    if (value.chr == &commandChar) {
+      noteCommandAckSent(link.connHandle, value.data[0]);
+    }
+  }
+  value.pendingLinks &= ~bit;  // Sent, or nobody subscribed on this link
+  return true;
+}
+
+// One-shot events (acks, legacy stroke events) have no newer value to wait for, so they
+// go out on every pass instead of waiting for the radio window
+bool sendLinkEvents(uint8_t index) {
+  BleLink& link = bleLinks[index];
+  uint8_t bit = 1 << index;
+  for (uint8_t i = 0; i < telemetryTx.eventCount; i++) {
+    if (!sendTelemetryValue(link, bit, telemetryTx.events[(telemetryTx.eventHead + i) % TX_EVENT_QUEUE_LEN])) {
+      link.stalls++;
+      return false;
+    }
+  }
+  return true;
+}
+
+// Retire events every link has been sent
+void retireTelemetryEvents() {
+  while (telemetryTx.eventCount > 0 && telemetryTx.events[telemetryTx.eventHead].pendingLinks == 0) {
+    telemetryTx.eventHead = (telemetryTx.eventHead + 1) % TX_EVENT_QUEUE_LEN;
+    telemetryTx.eventCount--;
+  }
+}
+
+// Drain this link's share of the queue: connection status, status values, events, stroke records
+void serviceLinkTx(uint8_t index) {
+  BleLink& link = bleLinks[index];
+  uint8_t bit = 1 << index;
+
+  if (link.connStatusPending) {
+    if (connectionStatusChar.notifyEnabled(link.connHandle)) {
+      uint8_t status[7];
+      encodeConnectionStatus(&link, status);
+      if (!sendTelemetry(link, connectionStatusChar, status, 7)) {
+        link.stalls++;
+        return;
+      }
+    }
+    link.connStatusPending = false;
+  }
+
+  for (uint8_t i = 0; i < TX_SLOT_COUNT; i++) {
+    if (!sendTelemetryValue(link, bit, telemetryTx.slots[i])) {
+      link.stalls++;
+      return;
+    }
+  }
+
+  if (!sendLinkEvents(index)) {
+    return;
+  }
+
+  if (!strokeRecordChar.notifyEnabled(link.connHandle)) {
+    if (millis() - link.params.connectedAt < RECONNECT_SUBSCRIBE_GRACE_MS) {
+      return;  // A bonded central's subscription is restored once the link is encrypted
+    }
+    link.strokeSent = strokeTelemetry.count;  // Not subscribed - nothing owed to this link
+    return;
+  }
+  while (link.strokeSent < strokeTelemetry.count) {
+    if (!sendStrokeBatch(link)) {
+      link.stalls++;
+      return;
+    }
+  }
+}
+
+// Called from loop(): return completed credits, drain every link, then retire entries
+// that all links have been sent
+void serviceTelemetryTx() {
+  for (uint8_t i = 0; i < BLE_MAX_LINKS; i++) {
+    BleLink& link = bleLinks[i];
+    if (!link.active) continue;
+
+    uint32_t completed = link.txCompleted;
+    if (completed != link.txCompletedSeen) {
+      uint32_t freed = completed - link.txCompletedSeen;
+      link.txCompletedSeen = completed;
+      link.credits = min((uint32_t)TX_CREDITS, link.credits + freed);
+    }
+  }
+
+  serviceBulkTransfer();  // Spare credits every pass - bulk throughput does not wait for the window
+  serviceRadioLatency();
+  if (!telemetryTxWindowOpen()) {
+    // Keep coalescing the latest-value slots - the next radio event is not close yet
+    for (uint8_t i = 0; i < BLE_MAX_LINKS; i++) {
+      if (bleLinks[i].active) sendLinkEvents(i);
+    }
+    retireTelemetryEvents();
+    return;
+  }
+
+  uint8_t minStrokeSent = 0xFF;
+  for (uint8_t i = 0; i < BLE_MAX_LINKS; i++) {
+    BleLink& link = bleLinks[i];
+    if (!link.active) continue;
+
+    serviceLinkTx(i);
+    minStrokeSent = min(minStrokeSent, link.strokeSent);
+  }
+  if (reconnectState.awaiting) {
+    minStrokeSent = min(minStrokeSent, reconnectState.strokeSent);  // Held for the dropped session central
+  }
+
+  retireTelemetryEvents();
+
+  // Records every link has been sent leave the ring
+  if (minStrokeSent == 0xFF) {
+    strokeTelemetry.count = 0;
+    return;
+  }
+  if (minStrokeSent > 0) {
+    strokeTelemetry.head = (strokeTelemetry.head + minStrokeSent) % STROKE_RING_RECORDS;
+    strokeTelemetry.count -= minStrokeSent;
+    for (uint8_t i = 0; i < BLE_MAX_LINKS; i++) {
+      if (bleLinks[i].active) bleLinks[i].strokeSent -= minStrokeSent;
+    }
+    if (reconnectState.awaiting) {
+      reconnectState.strokeSent -= minStrokeSent;
+    }
+  }
+}
+
+// BLE task context: only count TX completions, the loop folds them into credits
+void onBleEvent(ble_evt_t* evt) {
+  if (evt->header.evt_id == BLE_GATTS_EVT_HVN_TX_COMPLETE) {
+    BleLink* link = findLink(evt->evt.gatts_evt.conn_handle);
+    if (link) {
+      link->txCompleted += evt->evt.gatts_evt.params.hvn_tx_complete.count;
+    }
+  } else if (evt->header.evt_id == BLE_GAP_EVT_ADV_SET_TERMINATED) {
+    reconnectState.advertisingEnded = true;
+  }
+}
+
+// Forget everything still owed to a link that has gone away
+void releaseLinkTx(uint8_t index) {
+  uint8_t bit = 1 << index;
+  for (uint8_t i = 0; i < TX_SLOT_COUNT; i++) {
+    telemetryTx.slots[i].pendingLinks &= ~bit;
+  }
+  for (uint8_t i = 0; i < TX_EVENT_QUEUE_LEN; i++) {
+    telemetryTx.events[i].pendingLinks &= ~bit;
+  }
+}
+
+void printTelemetryStats() {
+  Serial.println("\n=== TELEMETRY TX QUEUE ===");
+  Serial.print("Notifications sent:   "); Serial.println(telemetryTx.sent);
+  Serial.print("Status coalesced:     "); Serial.println(telemetryTx.coalesced);
+  Serial.print("Events queued / max:  "); Serial.print(telemetryTx.eventCount); Serial.print(" / "); Serial.println(telemetryTx.maxEventDepth);
+  Serial.print("Events dropped:       "); Serial.println(telemetryTx.eventDrops);
+  Serial.print("Acks dropped:         "); Serial.println(telemetryTx.ackDrops);
+  Serial.print("Notify refused:       "); Serial.println(telemetryTx.failed);
+  Serial.print("Stroke records:       "); Serial.println(strokeTelemetry.recordsQueued);
+  Serial.print("Stroke queued / max:  "); Serial.print(strokeTelemetry.count); Serial.print(" / "); Serial.println(strokeTelemetry.maxDepth);
+  Serial.print("Stroke overflowed:    "); Serial.println(strokeTelemetry.recordsOverflowed);
+  if (strokeTelemetry.notifications > 0) {
+    Serial.print("Stroke batches sent:  "); Serial.println(strokeTelemetry.notifications);
+  }
+  printStatusPublisherStats();
+  printLinkStats();
+}
+
+// Report MTU / data length / PHY and connection parameters once each central has answered
+// the requests from handleLinkConnected
+void serviceLinkMonitor() {
+  for (uint8_t i = 0; i < BLE_MAX_LINKS; i++) {
+    BleLink& link = bleLinks[i];
+    if (!link.active || millis() - link.link.lastPoll < BLE_LINK_POLL_INTERVAL_MS) {
+      continue;
+    }
+    link.link.lastPoll = millis();
+
+    BLEConnection* connection = Bluefruit.Connection(link.connHandle);
+    if (!connection) continue;
+
+    uint16_t interval = connection->getConnectionInterval();
+    uint16_t latency = connection->getSlaveLatency();
+    uint16_t timeout = connection->getSupervisionTimeout();
+    if (interval != link.link.interval || latency != link.link.latency || timeout != link.link.timeout) {
+      link.link.interval = interval;
+      link.link.latency = latency;
+      link.link.timeout = timeout;
+
+      Serial.print("Link ");
+      Serial.print(i);
+      Serial.print(": connection parameters: interval ");
+      Serial.print(interval * 1.25f, 2);
+      Serial.print("ms | latency ");
+      Serial.print(latency);
+      Serial.print(" | timeout ");
+      Serial.print(timeout * 10);
+      Serial.println("ms");
+    }
+
+    uint16_t mtu = connection->getMtu();
+    uint16_t dataLength = connection->getDataLength();
+    uint8_t phy = connection->getPHY();
+    if (mtu == link.link.mtu && dataLength == link.link.dataLength && phy == link.link.phy) {
+      continue;
+    }
+
+    link.link.mtu = mtu;
+    link.link.dataLength = dataLength;
+    link.link.phy = phy;
+
+    Serial.print("Link ");
+    Serial.print(i);
+    Serial.print(": MTU ");
+    Serial.print(mtu);
+    Serial.print(" | data length ");
+    Serial.print(dataLength);
+    Serial.print(" | PHY ");
+    Serial.print(phy == BLE_GAP_PHY_2MBPS ? "2M" : "1M");
+    Serial.print(" | stroke records per notification ");
+    Serial.println(strokeBatchCapacity(link));
+
+    link.connStatusPending = true;
+  }
+}
+
+// ============================================================================
+// STROKE DETECTION AND CALIBRATION
+// ============================================================================
 
 void handleStrokeDetection() {
   // Read accelerometer data
@@ -1281,27 +4442,76 @@ void handleStrokeDetection() {
   float accelY = imu.readFloatAccelY();
   float accelZ = imu.readFloatAccelZ();
 
+  // Read gyroscope data - blade entry shows up first as a spike in angular rate
+  float gyroX = imu.readFloatGyroX();
+  float gyroY = imu.readFloatGyroY();
+  float gyroZ = imu.readFloatGyroZ();
+  float gyroRate = sqrtf(gyroX * gyroX + gyroY * gyroY + gyroZ * gyroZ);
+
   // Calculate total acceleration magnitude (forward/backward axis - typically Y for rowing)
   // Using Y-axis as primary stroke direction
   float strokeAccel = accelY;
 
+  // While our own haptic effect is playing, hold the last clean sample instead
+  bool blanked = isHapticBlanking();
+  if (blanked) {
+    strokeAccel = hapticBlanking.heldAccel;
+    gyroRate = hapticBlanking.heldGyroRate;
+    hapticBlanking.blankedSamples++;
+  } else {
+    hapticBlanking.heldAccel = strokeAccel;
+    hapticBlanking.heldGyroRate = gyroRate;
+  }
+
+  // The held rate predates the effect; a rise measured against it on the first clean sample
+  // is not an onset, so that sample re-seeds the baseline
+  bool reseed = !blanked && hapticBlanking.wasBlanked;
+  if (reseed) {
+    strokeDetectorReseed(strokeDetector, gyroRate);
+  }
+  hapticBlanking.wasBlanked = blanked;
+
+  unsigned long currentTime = millis();
+
+  // Sample log for tools/catch_replay: exactly what the detector sees, plus the re-seed flag
+  if (strokeDetection.logSamples && !calibrationState.active) {
+    Serial.print("IMU,");
+    Serial.print(currentTime);
+    Serial.print(",");
+    Serial.print(strokeAccel, 3);
+    Serial.print(",");
+    Serial.print(gyroRate, 1);
+    Serial.print(",");
+    Serial.println(reseed ? 1 : 0);
+  }
+
   // Debug: Print raw values every 100ms (roughly every 10 samples at 104Hz)
   static unsigned long lastDebugPrint = 0;
-  if (!calibrationState.active && millis() - lastDebugPrint > 100) {
+  if (!calibrationState.active && !strokeDetection.logSamples && millis() - lastDebugPrint > 100) {
     Serial.print("Accel X=");
     Serial.print(accelX, 2);
     Serial.print("g, Y=");
     Serial.print(accelY, 2);
     Serial.print("g, Z=");
     Serial.print(accelZ, 2);
-    Serial.print("g | Threshold=");
+    Serial.print("g | Gyro=");
+    Serial.print(gyroRate, 0);
+    Serial.print("dps | Threshold=");
     Serial.print(strokeDetection.threshold, 2);
-    Serial.println("g");
+    Serial.println(blanked ? "g [haptic blanked]" : "g");
     lastDebugPrint = millis();
   }
 
   // Handle calibration mode
   if (calibrationState.active) {
+    // The detector sees no samples meanwhile; keep its gyro baseline current
+    strokeDetectorReseed(strokeDetector, gyroRate);
+
+    // Motor-contaminated samples would inflate the peak and the suggested threshold
+    if (blanked) {
+      return;
+    }
+
     calibrationState.sampleCount++;
 
     if (strokeAccel > calibrationState.maxAccelSeen) {
@@ -1330,111 +4540,206 @@ void handleStrokeDetection() {
   }
 
   // Stroke detection state machine
-  unsigned long currentTime = millis();
+  StrokeStep step = strokeDetectorUpdate(strokeDetector, currentTime, strokeAccel, gyroRate,
+                                         strokeDetection.threshold);
 
-  switch (strokeDetection.currentPhase) {
-    case STROKE_PHASE_RECOVERY:
-      if (!strokeDetection.inStroke &&
-          strokeDetection.lastStrokeTime != 0 &&
-          (currentTime - strokeDetection.lastStrokeTime) < STROKE_MIN_INTERVAL_MS) {
-        break;
-      }
-      // Waiting for catch - detect forward acceleration threshold
-      if (strokeAccel > strokeDetection.threshold) {
-        // Stroke catch detected!
-        strokeDetection.currentPhase = STROKE_PHASE_CATCH;
-        strokeDetection.maxAccel = strokeAccel;
-        strokeDetection.inStroke = true;
+  if (step.leadMeasured) {
+    Serial.print("Catch lead over accel-only: ");
+    Serial.print(step.leadMs);
+    Serial.println("ms");
+  }
 
-        // Send stroke event
-        sendStrokeEvent(STROKE_PHASE_CATCH, currentTime, strokeAccel);
+  if (!step.transition) {
+    return;
+  }
 
-        Serial.println("CATCH detected");
-      }
+  switch (step.phase) {
+    case STROKE_PHASE_CATCH:
+      sendStrokeEvent(STROKE_PHASE_CATCH, step.phaseTime, strokeAccel);
+      Serial.println(step.gyroCatch ? "CATCH detected (gyro)" : "CATCH detected");
       break;
 
-    case STROKE_PHASE_CATCH:
-      // Track peak acceleration during drive
-      if (strokeAccel > strokeDetection.maxAccel) {
-        strokeDetection.maxAccel = strokeAccel;
-      }
+    case STROKE_PHASE_DRIVE:
+      sendStrokeEvent(STROKE_PHASE_DRIVE, currentTime, strokeAccel);
+      Serial.println("DRIVE phase");
+      break;
+
+    case STROKE_PHASE_FINISH: {
+      // Count this as a completed stroke
+      trainingState.currentStroke++;
+      updateDeviceStatus();
 
-      // Transition to drive when acceleration starts decreasing (from peak ~1.8g to ~1.2g)
-      if (strokeAccel < strokeDetection.maxAccel * 0.65) {
-        strokeDetection.currentPhase = STROKE_PHASE_DRIVE;
-        sendStrokeEvent(STROKE_PHASE_DRIVE, currentTime, strokeAccel);
-        Serial.println("DRIVE phase");
+      // Play zone-patterned haptic for the pacer device
+      uint8_t pattern = PATTERN_STRONG_CLICK;
+      switch (trainingConfig.zoneColor) {
+        case 0x01:
+          pattern = PATTERN_SOFT_CLICK;
+          break;
+        case 0x02:
+          pattern = PATTERN_STRONG_CLICK;
+          break;
+        case 0x03:
+          pattern = PATTERN_DOUBLE_CLICK;
+          break;
+        case 0x04:
+          pattern = PATTERN_TRIPLE_CLICK;
+          break;
+        case 0x05:
+          pattern = PATTERN_ALERT_750MS;
+          break;
+        case 0x06:
+          pattern = PATTERN_TRANSITION;
+          break;
+      }
+      if (trainingConfig.strokePattern != 0 && findCustomPattern(trainingConfig.strokePattern)) {
+        pattern = trainingConfig.strokePattern;
       }
+      playHapticPattern(pattern, 100, HAPTIC_PRIO_PACING);
+
+      // Send stroke event
+      sendStrokeEvent(STROKE_PHASE_FINISH, currentTime, strokeAccel);
+
+      Serial.print("FINISH - Stroke #");
+      Serial.println(trainingState.currentStroke);
+      break;
+    }
+
+    case STROKE_PHASE_RECOVERY:
+      queueStrokeRecord(currentTime);
+      sendStrokeEvent(STROKE_PHASE_RECOVERY, currentTime, strokeAccel);
+      Serial.println("RECOVERY phase");
       break;
+  }
+}
 
-    case STROKE_PHASE_DRIVE:
-      // Detect finish - when acceleration crosses near zero (based on paddle data: 0 to -0.5g range)
-      if (strokeAccel < 0.0) {
-        strokeDetection.currentPhase = STROKE_PHASE_FINISH;
-        strokeDetection.minAccel = strokeAccel;
-
-        // Count this as a completed stroke
-        trainingState.currentStroke++;
-        updateDeviceStatus();
-
-        // Play zone-patterned haptic for the pacer device
-        uint8_t pattern = PATTERN_STRONG_CLICK;
-        switch (trainingConfig.zoneColor) {
-          case 0x01:
-            pattern = PATTERN_SOFT_CLICK;
-            break;
-          case 0x02:
-            pattern = PATTERN_STRONG_CLICK;
-            break;
-          case 0x03:
-            pattern = PATTERN_DOUBLE_CLICK;
-            break;
-          case 0x04:
-            pattern = PATTERN_TRIPLE_CLICK;
-            break;
-          case 0x05:
-            pattern = PATTERN_ALERT_750MS;
-            break;
-          case 0x06:
-            pattern = PATTERN_TRANSITION;
-            break;
-        }
-        playHapticEffect(pattern, 100);
+// Pack the completed stroke into one record; phase times are offsets from the catch.
+// Record: [stroke(2)][catch_ms(4)][drive_off(2)][finish_off(2)][recovery_off(2)][peak(2)][min(2)]
+void queueStrokeRecord(unsigned long recoveryTime) {
+  strokeTelemetry.strokeIndex++;
+  if (!anyLinkSubscribed(strokeRecordChar) && !reconnectState.awaiting) {
+    return;
+  }
 
-        // Send stroke event
-        sendStrokeEvent(STROKE_PHASE_FINISH, currentTime, strokeAccel);
+  if (strokeTelemetry.count == STROKE_RING_RECORDS) {
+    // Stalled for a whole ring of strokes - keep the newest. The oldest record is overwritten
+    // (documented in BLE_PROTOCOL.md 1.6); the central sees the gap in the stroke numbers.
+    strokeTelemetry.head = (strokeTelemetry.head + 1) % STROKE_RING_RECORDS;
+    strokeTelemetry.count--;
+    strokeTelemetry.recordsOverflowed++;
+    for (uint8_t i = 0; i < BLE_MAX_LINKS; i++) {
+      if (bleLinks[i].strokeSent > 0) bleLinks[i].strokeSent--;
+    }
+    if (reconnectState.strokeSent > 0) reconnectState.strokeSent--;
+  }
 
-        Serial.print("FINISH - Stroke #");
-        Serial.println(trainingState.currentStroke);
+  unsigned long catchTime = strokeDetector.catchTime;
+  uint32_t catchStamp = syncedMillis(catchTime);
+  uint16_t driveOffset = (uint16_t)min(strokeDetector.driveTime - catchTime, 0xFFFFUL);
+  uint16_t finishOffset = (uint16_t)min(strokeDetector.finishTime - catchTime, 0xFFFFUL);
+  uint16_t recoveryOffset = (uint16_t)min(recoveryTime - catchTime, 0xFFFFUL);
+  int16_t peak = (int16_t)(strokeDetector.maxAccel * 100.0);
+  int16_t minimum = (int16_t)(strokeDetector.minAccel * 100.0);
+
+  uint8_t slot = (strokeTelemetry.head + strokeTelemetry.count) % STROKE_RING_RECORDS;
+  uint8_t* record = strokeTelemetry.ring[slot];
+  strokeTelemetry.synced[slot] = timeSync.synced;
+  strokeTelemetry.queuedUs[slot] = micros();
+  record[0] = strokeTelemetry.strokeIndex & 0xFF;
+  record[1] = strokeTelemetry.strokeIndex >> 8;
+  record[2] = (catchStamp >> 0) & 0xFF;
+  record[3] = (catchStamp >> 8) & 0xFF;
+  record[4] = (catchStamp >> 16) & 0xFF;
+  record[5] = (catchStamp >> 24) & 0xFF;
+  record[6] = driveOffset & 0xFF;
+  record[7] = driveOffset >> 8;
+  record[8] = finishOffset & 0xFF;
+  record[9] = finishOffset >> 8;
+  record[10] = recoveryOffset & 0xFF;
+  record[11] = recoveryOffset >> 8;
+  record[12] = peak & 0xFF;
+  record[13] = (peak >> 8) & 0xFF;
+  record[14] = minimum & 0xFF;
+  record[15] = (minimum >> 8) & 0xFF;
+
+  strokeTelemetry.count++;
+  strokeTelemetry.recordsQueued++;
+  if (strokeTelemetry.count > strokeTelemetry.maxDepth) {
+    strokeTelemetry.maxDepth = strokeTelemetry.count;
+  }
+}
 
-        // Update last stroke time
-        strokeDetection.lastStrokeTime = currentTime;
-      }
+// Records that fit one notification at this link's negotiated ATT MTU
+uint8_t strokeBatchCapacity(const BleLink& link) {
+  BLEConnection* connection = Bluefruit.Connection(link.connHandle);
+  uint16_t mtu = connection ? connection->getMtu() : 23;
+  int capacity = (mtu - 3 - STROKE_BATCH_HEADER) / STROKE_RECORD_SIZE;
+  return (uint8_t)constrain(capacity, 1, STROKE_BATCH_MAX_RECORDS);
+}
+
+// Send as many records this link has not seen as fit one notification. While credits are
+// exhausted records accumulate, so a congested link automatically gets fuller batches.
+// A batch never mixes device-clock and synchronized timestamps (count bit 7 = synchronized).
+bool sendStrokeBatch(BleLink& link) {
+  uint8_t count = min((uint8_t)(strokeTelemetry.count - link.strokeSent), strokeBatchCapacity(link));
+  bool synced = strokeTelemetry.synced[(strokeTelemetry.head + link.strokeSent) % STROKE_RING_RECORDS];
+  for (uint8_t i = 1; i < count; i++) {
+    if (strokeTelemetry.synced[(strokeTelemetry.head + link.strokeSent + i) % STROKE_RING_RECORDS] != synced) {
+      count = i;
       break;
+    }
+  }
+
+  uint8_t data[STROKE_BATCH_HEADER + STROKE_BATCH_MAX_RECORDS * STROKE_RECORD_SIZE];
+  data[0] = link.strokeSequence;
+  data[1] = count | (synced ? 0x80 : 0);
+  for (uint8_t i = 0; i < count; i++) {
+    uint8_t slot = (strokeTelemetry.head + link.strokeSent + i) % STROKE_RING_RECORDS;
+    memcpy(data + STROKE_BATCH_HEADER + i * STROKE_RECORD_SIZE, strokeTelemetry.ring[slot], STROKE_RECORD_SIZE);
+  }
+
+  if (!sendTelemetry(link, strokeRecordChar, data, STROKE_BATCH_HEADER + count * STROKE_RECORD_SIZE)) {
+    return false;  // Records stay in the ring
+  }
 
-    case STROKE_PHASE_FINISH:
-      // Track minimum (most negative) acceleration during recovery (expected ~-2.4g)
-      if (strokeAccel < strokeDetection.minAccel) {
-        strokeDetection.minAccel = strokeAccel;
-      }
+  for (uint8_t i = 0; i < count; i++) {
+    noteRecordHandover(strokeTelemetry.queuedUs[(strokeTelemetry.head + link.strokeSent + i) % STROKE_RING_RECORDS]);
+  }
+  link.strokeSequence++;
+  link.strokeSent += count;
+  strokeTelemetry.notifications++;
+  return true;
+}
 
-      // Return to recovery phase when acceleration returns toward positive (recovery ends around -0.5g to 0g)
-      if (strokeAccel > -0.5) {
-        strokeDetection.currentPhase = STROKE_PHASE_RECOVERY;
-        strokeDetection.inStroke = false;
-        strokeDetection.maxAccel = 0.0;
-        strokeDetection.minAccel = 0.0;
-        sendStrokeEvent(STROKE_PHASE_RECOVERY, currentTime, strokeAccel);
-        Serial.println("RECOVERY phase");
-      }
-      break;
+void printCatchLatencyStats() {
+  const CatchLatencyStats& stats = strokeDetector.stats;
+
+  Serial.println("\n=== CATCH DETECTION LATENCY ===");
+  Serial.print("Gyro-confirmed catches: "); Serial.println(stats.gyroCatches);
+  Serial.print("Accel-only catches:     "); Serial.println(stats.accelOnlyCatches);
+  Serial.print("Missed by accel-only:   "); Serial.println(stats.gyroOnlyCatches);
+  Serial.print("Rejected gyro onsets:   "); Serial.println(stats.rejectedOnsets);
+  Serial.print("Haptic-blanked samples: "); Serial.println(hapticBlanking.blankedSamples);
+  if (stats.leadSamples > 0) {
+    Serial.print("Lead over accel-only (ms): avg ");
+    Serial.print(stats.leadSumMs / (float)stats.leadSamples, 1);
+    Serial.print(" | min ");
+    Serial.print(stats.leadMinMs);
+    Serial.print(" | max ");
+    Serial.print(stats.leadMaxMs);
+    Serial.print(" | n=");
+    Serial.println(stats.leadSamples);
+  } else {
+    Serial.println("No lead measurements yet");
   }
 }
 
 void sendStrokeEvent(StrokePhase phase, unsigned long timestamp, float accelMagnitude) {
-  if (!Bluefruit.connected()) return;
+  // Legacy per-phase events (four packets per stroke) only for centrals that still subscribe
+  if (!anyLinkSubscribed(strokeEventChar)) return;
 
   // Format: [phase(1)][timestamp_ms(4)][accel_magnitude(2 bytes as int16)]
+  // Always device millis(): the format has no room to flag phone-clock time, and legacy apps
+  // compare it with their own device-clock bookkeeping
   uint8_t data[7];
   data[0] = (uint8_t)phase;
   data[1] = (timestamp >> 0) & 0xFF;
@@ -1447,12 +4752,20 @@ void sendStrokeEvent(StrokePhase phase, unsigned long timestamp, float accelMagn
   data[5] = (accelInt >> 0) & 0xFF;
   data[6] = (accelInt >> 8) & 0xFF;
 
-  strokeEventChar.notify(data, 7);
+  queueTelemetryEvent(strokeEventChar, data, 7);
 }
 
-void onCalibrationWrite(uint16_t conn_hdl, BLECharacteristic* chr, uint8_t* data, uint16_t len) {
+void handleCalibrationWrite(uint16_t conn_hdl, uint8_t* data, uint16_t len) {
+  if (!acquireControl(conn_hdl)) {
+    return;
+  }
+
   if (len < 1) return;
 
+  executeCalibrationCommand(data, len);
+}
+
+void executeCalibrationCommand(const uint8_t* data, uint16_t len) {
   uint8_t command = data[0];
 
   switch (command) {
@@ -1475,7 +4788,7 @@ void onCalibrationWrite(uint16_t conn_hdl, BLECharacteristic* chr, uint8_t* data
 
         // Acknowledge
         uint8_t response[4] = {CAL_CMD_SET_THRESHOLD, data[1], data[2], 0x01};
-        calibrationChar.notify(response, 4);
+        queueTelemetryAck(calibrationChar, response, 4);  // One-shot - must not be coalesced with status
       }
       break;
 
@@ -1498,7 +4811,7 @@ void startCalibration() {
   updateDeviceStatus();
 
   // Play start haptic
-  playHapticEffect(PATTERN_TRIPLE_CLICK, 100);
+  playHapticEffect(PATTERN_TRIPLE_CLICK, 100, HAPTIC_PRIO_SESSION);
 
   sendCalibrationStatus();
 }
@@ -1509,7 +4822,7 @@ void stopCalibration() {
   trainingState.deviceState = STATE_READY;
   updateDeviceStatus();
 
-  playHapticEffect(PATTERN_SOFT_CLICK, 60);
+  playHapticEffect(PATTERN_SOFT_CLICK, 60, HAPTIC_PRIO_CONFIRM);
   sendCalibrationStatus();
 }
 
@@ -1534,10 +4847,9 @@ void completeCalibration() {
   trainingState.deviceState = STATE_READY;
   updateDeviceStatus();
 
-  // Play completion haptic
-  playHapticEffect(PATTERN_ALERT_750MS, 100);
-  delay(800);
-  playHapticEffect(PATTERN_DOUBLE_CLICK, 80);
+  // Play completion haptic (alert, 50ms gap, double click) from the sequencer
+  static const uint8_t calibrationCompleteCue[] = {PATTERN_ALERT_750MS, HAPTIC_WAIT(50), PATTERN_DOUBLE_CLICK};
+  playHapticSequence(calibrationCompleteCue, sizeof(calibrationCompleteCue), HAPTIC_PRIO_SESSION);
 
   sendCalibrationStatus();
 }
@@ -1554,7 +4866,866 @@ void sendCalibrationStatus() {
   data[2] = (thresholdInt >> 8) & 0xFF;
   data[3] = calibrationState.active ? 0x01 : 0x00;
 
-  calibrationChar.notify(data, 4);
+  queueTelemetryValue(TX_SLOT_CALIBRATION, calibrationChar, data, 4);
+}
+
+// ============================================================================
+// CUSTOM HAPTIC PATTERNS
+// ============================================================================
+
+void loadPatternLibrary() {
+  if (!loadBlob(CUSTOM_PATTERN_FILE, &patternLibrary, sizeof(patternLibrary)) ||
+      patternLibrary.magic != CUSTOM_PATTERN_MAGIC) {
+    memset(&patternLibrary, 0, sizeof(patternLibrary));
+    patternLibrary.magic = CUSTOM_PATTERN_MAGIC;
+  }
+
+  uint8_t loaded = 0;
+  for (uint8_t i = 0; i < CUSTOM_PATTERN_SLOTS; i++) {
+    if (patternLibrary.patterns[i].id != 0) loaded++;
+  }
+  Serial.print("Custom haptic patterns loaded: ");
+  Serial.println(loaded);
+}
+
+const CustomHapticPattern* findCustomPattern(uint8_t id) {
+  if (id < CUSTOM_PATTERN_BASE || id >= CUSTOM_PATTERN_BASE + CUSTOM_PATTERN_SLOTS) {
+    return NULL;
+  }
+  const CustomHapticPattern* pattern = &patternLibrary.patterns[id - CUSTOM_PATTERN_BASE];
+  return pattern->id == id ? pattern : NULL;
+}
+
+// Play a built-in effect (HapticPattern) or a custom library pattern (0x80+).
+// Custom sequences play library effects at fixed amplitude; envelopes honour intensity.
+bool playHapticPattern(uint8_t id, uint8_t intensity, HapticPriority priority) {
+  if (id < CUSTOM_PATTERN_BASE) {
+    playHapticEffect(id, intensity, priority);
+    return true;
+  }
+
+  const CustomHapticPattern* pattern = findCustomPattern(id);
+  if (!pattern) {
+    Serial.print("ERROR: Unknown custom pattern 0x");
+    Serial.println(id, HEX);
+    return false;
+  }
+
+  if (pattern->type == CUSTOM_PATTERN_ENVELOPE) {
+    requestHapticEnvelope(pattern->envelope, pattern->count, intensity, priority);
+  } else if (intensity > 0) {
+    playHapticSequence(pattern->sequence, pattern->count, priority);
+  }
+  return true;
+}
+
+void handlePatternUploadWrite(uint16_t conn_hdl, uint8_t* data, uint16_t len) {
+  if (!acquireControl(conn_hdl)) {
+    return;
+  }
+
+  if (len < 1) {
+    return;
+  }
+
+  uint8_t op = data[0];
+  uint8_t id = (len > 1) ? data[1] : 0;
+  noteLinkStreaming(conn_hdl);
+
+  switch (op) {
+    case PATTERN_OP_BEGIN: {
+      // [op][id][type][count][name...]
+      if (len < 4) {
+        sendPatternUploadStatus(op, id, PATTERN_STATUS_BAD_LENGTH);
+        return;
+      }
+      if (id < CUSTOM_PATTERN_BASE || id >= CUSTOM_PATTERN_BASE + CUSTOM_PATTERN_SLOTS) {
+        sendPatternUploadStatus(op, id, PATTERN_STATUS_BAD_ID);
+        return;
+      }
+
+      uint8_t type = data[2];
+      uint8_t count = data[3];
+      uint8_t maxCount = (type == CUSTOM_PATTERN_SEQUENCE) ? HAPTIC_SEQ_SLOTS : HAPTIC_RTP_MAX_POINTS;
+      if (type > CUSTOM_PATTERN_ENVELOPE || count == 0 || count > maxCount) {
+        sendPatternUploadStatus(op, id, PATTERN_STATUS_INVALID);
+        return;
+      }
+
+      memset(&patternUpload, 0, sizeof(patternUpload));
+      patternUpload.pattern.id = id;
+      patternUpload.pattern.type = type;
+      patternUpload.pattern.count = count;
+      memcpy(patternUpload.pattern.name, data + 4, min((uint16_t)(len - 4), (uint16_t)CUSTOM_PATTERN_NAME_LEN));
+      patternUpload.expected = (type == CUSTOM_PATTERN_SEQUENCE) ? count : count * 3;
+      patternUpload.active = true;
+      sendPatternUploadStatus(op, id, PATTERN_STATUS_OK);
+      break;
+    }
+
+    case PATTERN_OP_DATA: {
+      // [op][offset][payload...] - offset lets the app detect a lost chunk
+      uint8_t offset = id;
+      id = patternUpload.pattern.id;
+      if (!patternUpload.active) {
+        sendPatternUploadStatus(op, id, PATTERN_STATUS_NO_UPLOAD);
+        return;
+      }
+      if (len < 2 || offset != patternUpload.received) {
+        patternUpload.active = false;
+        sendPatternUploadStatus(op, id, PATTERN_STATUS_BAD_OFFSET);
+        return;
+      }
+      uint16_t chunk = len - 2;
+      if (patternUpload.received + chunk > patternUpload.expected) {
+        patternUpload.active = false;
+        sendPatternUploadStatus(op, id, PATTERN_STATUS_BAD_LENGTH);
+        return;
+      }
+      memcpy(patternUpload.payload + patternUpload.received, data + 2, chunk);
+      patternUpload.received += chunk;
+      sendPatternUploadStatus(op, id, PATTERN_STATUS_OK);
+      break;
+    }
+
+    case PATTERN_OP_COMMIT:
+      id = patternUpload.pattern.id;
+      sendPatternUploadStatus(op, id, commitPatternUpload());
+      break;
+
+    case PATTERN_OP_DELETE: {
+      const CustomHapticPattern* pattern = findCustomPattern(id);
+      if (!pattern) {
+        sendPatternUploadStatus(op, id, PATTERN_STATUS_BAD_ID);
+        return;
+      }
+      memset(&patternLibrary.patterns[id - CUSTOM_PATTERN_BASE], 0, sizeof(CustomHapticPattern));
+      if (trainingConfig.strokePattern == id) {
+        trainingConfig.strokePattern = 0;
+      }
+      bool saved = saveBlob(CUSTOM_PATTERN_FILE, &patternLibrary, sizeof(patternLibrary));
+      sendPatternUploadStatus(op, id, saved ? PATTERN_STATUS_OK : PATTERN_STATUS_FLASH_ERROR);
+      break;
+    }
+
+    default:
+      Serial.println("ERROR: Unknown pattern upload op");
+      break;
+  }
+}
+
+// Validate the staged payload, install it in the RAM table and persist the library
+PatternUploadStatus commitPatternUpload() {
+  if (!patternUpload.active) {
+    return PATTERN_STATUS_NO_UPLOAD;
+  }
+  patternUpload.active = false;
+
+  if (patternUpload.received != patternUpload.expected) {
+    return PATTERN_STATUS_BAD_LENGTH;
+  }
+
+  CustomHapticPattern& pattern = patternUpload.pattern;
+  if (pattern.type == CUSTOM_PATTERN_SEQUENCE) {
+    for (uint8_t i = 0; i < pattern.count; i++) {
+      uint8_t entry = patternUpload.payload[i];
+      // 0 would terminate the chain early; the DRV2605L libraries hold effects 1-123
+      if (entry == 0 || entry == 0x80 || (!HAPTIC_IS_WAIT(entry) && entry > 123)) {
+        return PATTERN_STATUS_INVALID;
+      }
+      pattern.sequence[i] = entry;
+    }
+  } else {
+    uint32_t totalMs = 0;
+    for (uint8_t i = 0; i < pattern.count; i++) {
+      const uint8_t* point = patternUpload.payload + i * 3;
+      pattern.envelope[i].amplitude = point[0];
+      pattern.envelope[i].durationMs = point[1] | (point[2] << 8);
+      totalMs += pattern.envelope[i].durationMs;
+    }
+    if (totalMs > CUSTOM_PATTERN_MAX_ENVELOPE_MS) {
+      return PATTERN_STATUS_INVALID;
+    }
+  }
+
+  patternLibrary.patterns[pattern.id - CUSTOM_PATTERN_BASE] = pattern;
+  if (!saveBlob(CUSTOM_PATTERN_FILE, &patternLibrary, sizeof(patternLibrary))) {
+    return PATTERN_STATUS_FLASH_ERROR;
+  }
+
+  Serial.print("Custom pattern 0x");
+  Serial.print(pattern.id, HEX);
+  Serial.print(" stored: ");
+  Serial.println(pattern.name);
+  return PATTERN_STATUS_OK;
+}
+
+void sendPatternUploadStatus(uint8_t op, uint8_t id, uint8_t status) {
+  if (status != PATTERN_STATUS_OK) {
+    Serial.print("Pattern upload op 0x");
+    Serial.print(op, HEX);
+    Serial.print(" failed: status ");
+    Serial.println(status);
+  }
+
+  if (!Bluefruit.connected()) return;
+
+  uint8_t data[3] = {op, id, status};
+  queueTelemetryAck(patternUploadChar, data, 3);
+}
+
+void printPatternLibrary() {
+  Serial.println("\n=== CUSTOM HAPTIC PATTERNS ===");
+  uint8_t listed = 0;
+  for (uint8_t i = 0; i < CUSTOM_PATTERN_SLOTS; i++) {
+    const CustomHapticPattern& pattern = patternLibrary.patterns[i];
+    if (pattern.id == 0) continue;
+    listed++;
+    Serial.print("0x");
+    Serial.print(pattern.id, HEX);
+    Serial.print(" \"");
+    Serial.print(pattern.name);
+    Serial.print("\" ");
+    Serial.print(pattern.type == CUSTOM_PATTERN_ENVELOPE ? "envelope" : "sequence");
+    Serial.print(" x");
+    Serial.println(pattern.count);
+  }
+  if (listed == 0) {
+    Serial.println("No custom patterns stored");
+  }
+}
+
+// ============================================================================
+// TIME SYNCHRONIZATION
+// ============================================================================
+
+// The reference central answers each ping with its receive (t2) and send (t3) times; the
+// device stamps t1 when the ping is handed to the SoftDevice and t4 when the pong arrives.
+// Connection events make the two directions asymmetric by up to an interval, so only the
+// exchange with the smallest round trip of each round is kept. A least-squares line through
+// the last rounds gives offset and drift; between rounds telemetry is extrapolated along it.
+
+// Device micros() extended to 64 bits; called at least once per loop pass
+int64_t deviceMicros64() {
+  uint32_t now = micros();
+  if (now < timeSync.lastMicros) {
+    timeSync.microsHigh++;
+  }
+  timeSync.lastMicros = now;
+  return ((int64_t)timeSync.microsHigh << 32) | now;
+}
+
+// Extend a recent raw micros() value
+int64_t extendMicros(uint32_t raw) {
+  int64_t now = deviceMicros64();
+  return now - (uint32_t)((uint32_t)now - raw);
+}
+
+int64_t syncedMicros(int64_t deviceUs) {
+  float drift = timeSync.driftPpm * 1e-6f;
+  return deviceUs + timeSync.anchor.offsetUs + (int64_t)(drift * (float)(deviceUs - timeSync.anchor.deviceUs));
+}
+
+// Telemetry timestamp for a millis() value: low 32 bits of the reference clock in ms once
+// synchronized, device ms since boot until then
+uint32_t syncedMillis(unsigned long deviceMs) {
+  if (!timeSync.synced) {
+    return deviceMs;
+  }
+  int64_t deviceUs = deviceMicros64() - (int64_t)(millis() - deviceMs) * 1000;
+  return (uint32_t)(syncedMicros(deviceUs) / 1000);
+}
+
+void startTimeSyncRound() {
+  timeSync.roundActive = true;
+  timeSync.pingsSent = 0;
+  timeSync.awaitingPong = false;
+  timeSync.bestDelayUs = UINT32_MAX;
+  timeSync.lastRound = millis();
+  noteLinkStreaming(timeSync.connHandle);  // Short connection interval keeps the round trips tight
+}
+
+// Fit offset = a + b * (device time) through the stored rounds
+void fitTimeSync() {
+  uint8_t n = timeSync.historyCount;
+  const TimeSyncSample& newest = timeSync.history[(timeSync.historyNext + TIME_SYNC_HISTORY - 1) % TIME_SYNC_HISTORY];
+
+  double sx = 0, sy = 0, sxx = 0, sxy = 0;
+  for (uint8_t i = 0; i < n; i++) {
+    double x = (timeSync.history[i].deviceUs - newest.deviceUs) / 1e6;  // Seconds before the newest round
+    double y = timeSync.history[i].offsetUs - newest.offsetUs;
+    sx += x;
+    sy += y;
+    sxx += x * x;
+    sxy += x * y;
+  }
+
+  double slope = 0;  // us per second = ppm
+  double denominator = n * sxx - sx * sx;
+  if (n >= 2 && denominator > 1e-6) {
+    slope = (n * sxy - sx * sy) / denominator;
+  }
+  double intercept = (sy - slope * sx) / n;
+
+  double residual = 0;
+  for (uint8_t i = 0; i < n; i++) {
+    double x = (timeSync.history[i].deviceUs - newest.deviceUs) / 1e6;
+    double e = (timeSync.history[i].offsetUs - newest.offsetUs) - (intercept + slope * x);
+    residual += e * e;
+  }
+
+  timeSync.anchor.deviceUs = newest.deviceUs;
+  timeSync.anchor.offsetUs = newest.offsetUs + (int64_t)intercept;
+  timeSync.driftPpm = (float)slope;
+  timeSync.residualUs = (float)sqrt(residual / n);
+}
+
+void finishTimeSyncRound() {
+  timeSync.roundActive = false;
+  if (timeSync.bestDelayUs == UINT32_MAX) {
+    Serial.println("Time sync: no pong received this round");
+    return;
+  }
+
+  // How far the previous estimate had wandered - the achieved sync error
+  if (timeSync.synced) {
+    int64_t predicted = syncedMicros(timeSync.best.deviceUs) - timeSync.best.deviceUs;
+    int64_t error = predicted - timeSync.best.offsetUs;
+    timeSync.errorUs = (uint32_t)min((int64_t)UINT32_MAX, error < 0 ? -error : error);
+  }
+
+  timeSync.history[timeSync.historyNext] = timeSync.best;
+  timeSync.historyNext = (timeSync.historyNext + 1) % TIME_SYNC_HISTORY;
+  if (timeSync.historyCount < TIME_SYNC_HISTORY) {
+    timeSync.historyCount++;
+  }
+  fitTimeSync();
+  timeSync.boundUs = timeSync.bestDelayUs / 2;
+  timeSync.synced = true;
+  timeSync.rounds++;
+
+  // Format: [op][rounds][bound_us(2)][error_us(2)][drift_ppm x10 (int16)]
+  uint16_t bound = min(timeSync.boundUs, (uint32_t)0xFFFF);
+  uint16_t error = min(timeSync.errorUs, (uint32_t)0xFFFF);
+  int16_t drift = (int16_t)constrain(timeSync.driftPpm * 10.0f, -32768.0f, 32767.0f);
+  uint8_t result[8];
+  result[0] = TIME_SYNC_OP_RESULT;
+  result[1] = (uint8_t)min(timeSync.rounds, (uint16_t)0xFF);
+  result[2] = bound & 0xFF;
+  result[3] = bound >> 8;
+  result[4] = error & 0xFF;
+  result[5] = error >> 8;
+  result[6] = drift & 0xFF;
+  result[7] = (drift >> 8) & 0xFF;
+  queueTelemetryEvent(timeSyncChar, result, 8);
+
+  Serial.print("Time sync round ");
+  Serial.print(timeSync.rounds);
+  Serial.print(": min RTT ");
+  Serial.print(timeSync.bestDelayUs);
+  Serial.print("us | bound +/-");
+  Serial.print(timeSync.boundUs);
+  Serial.print("us | error ");
+  Serial.print(timeSync.errorUs);
+  Serial.print("us | drift ");
+  Serial.print(timeSync.driftPpm, 1);
+  Serial.println("ppm");
+}
+
+// Called from loop(): pace the pings of a round, fold in pongs, start periodic re-syncs
+void serviceTimeSync() {
+  deviceMicros64();  // Track micros() wrap
+
+  BleLink* link = findLink(timeSync.connHandle);
+  if (!link || !timeSyncChar.notifyEnabled(link->connHandle)) {
+    return;
+  }
+
+  if (timeSync.pongReady) {
+    uint8_t sequence = timeSync.pongSequence;
+    int64_t t2 = timeSync.pongT2;
+    int64_t t3 = timeSync.pongT3;
+    uint32_t t4 = timeSync.pongT4;
+    timeSync.pongReady = false;
+
+    if (timeSync.awaitingPong && sequence == timeSync.sequence) {
+      timeSync.awaitingPong = false;
+      timeSync.pongs++;
+
+      int64_t rtt = (int64_t)(uint32_t)(t4 - timeSync.pingT1) - (t3 - t2);
+      if (rtt >= 0 && rtt < timeSync.bestDelayUs) {
+        int64_t t1 = extendMicros(timeSync.pingT1);
+        int64_t t4Extended = extendMicros(t4);
+        timeSync.bestDelayUs = (uint32_t)rtt;
+        timeSync.best.deviceUs = t1 + (t4Extended - t1) / 2;
+        timeSync.best.offsetUs = ((t2 - t1) + (t3 - t4Extended)) / 2;
+      }
+    }
+  }
+
+  if (timeSync.awaitingPong && micros() - timeSync.pingT1 >= TIME_SYNC_PING_TIMEOUT_MS * 1000UL) {
+    timeSync.awaitingPong = false;
+    timeSync.lostPings++;
+  }
+
+  if (!timeSync.roundActive) {
+    bool session = trainingState.deviceState == STATE_TRAINING ||
+                   trainingState.deviceState == STATE_CALIBRATING;
+    unsigned long interval = session ? TIME_SYNC_SESSION_INTERVAL_MS : TIME_SYNC_IDLE_INTERVAL_MS;
+    if (millis() - timeSync.lastRound >= interval) {
+      startTimeSyncRound();
+    }
+    return;
+  }
+
+  if (timeSync.awaitingPong || millis() - timeSync.lastPing < TIME_SYNC_PING_SPACING_MS) {
+    return;
+  }
+  if (timeSync.pingsSent == TIME_SYNC_PINGS) {
+    finishTimeSyncRound();
+    return;
+  }
+
+  // Sent directly rather than through the telemetry queue so t1 is the hand-off time
+  uint8_t ping[6];
+  timeSync.sequence++;
+  uint32_t t1 = micros();
+  ping[0] = TIME_SYNC_OP_PING;
+  ping[1] = timeSync.sequence;
+  ping[2] = (t1 >> 0) & 0xFF;
+  ping[3] = (t1 >> 8) & 0xFF;
+  ping[4] = (t1 >> 16) & 0xFF;
+  ping[5] = (t1 >> 24) & 0xFF;
+  if (!sendTelemetry(*link, timeSyncChar, ping, 6)) {
+    timeSync.sequence--;
+    return;  // No credit - retried next pass
+  }
+
+  timeSync.pingT1 = t1;
+  timeSync.awaitingPong = true;
+  timeSync.lastPing = millis();
+  timeSync.pingsSent++;
+  timeSync.pings++;
+}
+
+int64_t readInt64(const uint8_t* data) {
+  uint64_t value = 0;
+  for (int i = 7; i >= 0; i--) {
+    value = (value << 8) | data[i];
+  }
+  return (int64_t)value;
+}
+
+void onTimeSyncWrite(uint16_t conn_hdl, BLECharacteristic* chr, uint8_t* data, uint16_t len) {
+  uint32_t received = micros();  // t4 - taken before anything else
+  if (len < 1) return;
+
+  if (data[0] == TIME_SYNC_OP_PONG && len >= 18) {
+    if (conn_hdl != timeSync.connHandle) return;
+    timeSync.pongSequence = data[1];
+    timeSync.pongT2 = readInt64(data + 2);
+    timeSync.pongT3 = readInt64(data + 10);
+    timeSync.pongT4 = received;
+    timeSync.pongReady = true;
+    return;
+  }
+
+  if (data[0] == TIME_SYNC_OP_START) {
+    // Only one reference clock: another central can take over once the current one has left
+    if (findLink(timeSync.connHandle) && conn_hdl != timeSync.connHandle) {
+      Serial.println("Time sync start ignored: another central is the reference");
+      return;
+    }
+    if (conn_hdl != timeSync.connHandle) {
+      timeSync.historyCount = 0;  // New reference clock - previous fit does not apply
+      timeSync.historyNext = 0;
+      timeSync.synced = false;
+      timeSync.errorUs = 0;
+    }
+    timeSync.connHandle = conn_hdl;
+    startTimeSyncRound();
+  }
+}
+
+void printTimeSyncStatus() {
+  Serial.println("\n=== CLOCK SYNCHRONIZATION ===");
+  Serial.print("Reference:      ");
+  Serial.println(findLink(timeSync.connHandle) ? "connected" : "none");
+  Serial.print("Synchronized:   ");
+  Serial.println(timeSync.synced ? "yes" : "no");
+  Serial.print("Rounds:         "); Serial.println(timeSync.rounds);
+  Serial.print("Pings / pongs:  "); Serial.print(timeSync.pings); Serial.print(" / "); Serial.print(timeSync.pongs);
+  Serial.print(" (lost "); Serial.print(timeSync.lostPings); Serial.println(")");
+  if (!timeSync.synced) return;
+  Serial.print("Offset bound:   +/-"); Serial.print(timeSync.boundUs); Serial.println("us (half min RTT)");
+  Serial.print("Last error:     "); Serial.print(timeSync.errorUs); Serial.println("us (prediction vs next round)");
+  Serial.print("Fit residual:   "); Serial.print(timeSync.residualUs, 0); Serial.println("us RMS");
+  Serial.print("Drift:          "); Serial.print(timeSync.driftPpm, 2); Serial.println("ppm");
+}
+
+// ============================================================================
+// BULK TRANSFER
+// ============================================================================
+
+// Moves files (session recordings, logs, assets) and throughput-test data over the Bulk
+// Transfer characteristic. An L2CAP connection-oriented channel would be the natural
+// transport, but Bluefruit configures the SoftDevice without L2CAP channels and offers no
+// API for them, so this mirrors CoC semantics on GATT instead: full-MTU frames plus credits
+// granted by the receiver (the central grants data frames, the device grants upload frames).
+
+uint16_t bulkFramePayload(uint16_t connHandle) {
+  BLEConnection* connection = Bluefruit.Connection(connHandle);
+  uint16_t mtu = connection ? connection->getMtu() : 23;
+  return mtu - 3 - BULK_FRAME_HEADER;
+}
+
+void queueBulkControl(const uint8_t* data, uint8_t len) {
+  memcpy(bulk.control, data, len);
+  bulk.controlLen = len;
+}
+
+// Queue END (and RESULT for a test) and release the file; the transfer goes idle once sent
+void endBulkTransfer(uint8_t status) {
+  if (bulkFile.isOpen()) {
+    bulkFile.close();
+  }
+  if (bulk.mode == BULK_WRITING && (status != BULK_STATUS_OK || bulk.bytes != bulk.size)) {
+    InternalFS.remove(bulk.path);  // Never leave a partial upload behind
+    if (status == BULK_STATUS_OK) status = BULK_STATUS_BAD_REQUEST;
+  }
+
+  unsigned long elapsed = max(1UL, (unsigned long)(millis() - bulk.startMs));
+  Serial.print("Bulk transfer ended: status ");
+  Serial.print(status);
+  Serial.print(" | ");
+  Serial.print(bulk.bytes);
+  Serial.print(" bytes in ");
+  Serial.print(elapsed);
+  Serial.print("ms (");
+  Serial.print(bulk.bytes / (float)elapsed, 1);  // bytes/ms = KB/s
+  Serial.println(" KB/s)");
+
+  if (bulk.mode == BULK_TESTING && status == BULK_STATUS_OK) {
+    BleLink* link = findLink(bulk.connHandle);
+    BulkTestResult result = {bulk.bytes, (uint32_t)elapsed, 23, BLE_GAP_PHY_1MBPS, 0, 27};
+    if (link) {
+      result.mtu = link->link.mtu;
+      result.phy = link->link.phy;
+      result.interval = link->link.interval;
+      result.dataLength = link->link.dataLength;
+    }
+    memmove(bulk.results + 1, bulk.results, sizeof(BulkTestResult) * (BULK_TEST_HISTORY - 1));
+    bulk.results[0] = result;
+    if (bulk.resultCount < BULK_TEST_HISTORY) bulk.resultCount++;
+    bulk.resultPending = true;  // Sent through the control slot right after END
+  }
+
+  uint8_t end[6] = {BULK_EVT_END, status,
+                    (uint8_t)(bulk.bytes >> 0), (uint8_t)(bulk.bytes >> 8),
+                    (uint8_t)(bulk.bytes >> 16), (uint8_t)(bulk.bytes >> 24)};
+  queueBulkControl(end, 6);
+  bulk.finishing = true;
+}
+
+void startBulkTransfer(uint8_t mode, uint16_t conn_hdl, uint16_t credits, uint32_t size) {
+  bulk.mode = mode;
+  bulk.connHandle = conn_hdl;
+  bulk.credits = credits;
+  bulk.sequence = 0;
+  bulk.size = size;
+  bulk.bytes = 0;
+  bulk.startMs = millis();
+  bulk.finishing = false;
+  bulk.resultPending = false;
+  bulk.creditGrant = 0;
+  noteLinkStreaming(conn_hdl);
+
+  uint8_t begin[5] = {BULK_EVT_BEGIN, (uint8_t)(size >> 0), (uint8_t)(size >> 8),
+                      (uint8_t)(size >> 16), (uint8_t)(size >> 24)};
+  queueBulkControl(begin, 5);
+}
+
+// A plain file name: no directories, no hidden or relative entries
+bool validBulkName(const uint8_t* name, uint16_t len) {
+  if (len == 0 || name[0] == '.') return false;
+  for (uint16_t i = 0; i < len; i++) {
+    if (name[i] == '/' || name[i] == '\\' || name[i] < 0x20) return false;
+  }
+  return true;
+}
+
+// Downloads are limited to "<dir>/<name>" in the session and asset directories, so bond
+// keys, calibration and pattern files are never served
+bool allowedBulkReadPath(const uint8_t* path, uint16_t len) {
+  static const char* dirs[] = {BULK_SESSION_DIR "/", BULK_ASSET_DIR "/"};
+  for (uint8_t i = 0; i < 2; i++) {
+    uint16_t prefix = strlen(dirs[i]);
+    if (len > prefix && memcmp(path, dirs[i], prefix) == 0) {
+      return validBulkName(path + prefix, len - prefix);
+    }
+  }
+  return false;
+}
+
+void rejectBulkRequest(uint16_t conn_hdl, uint8_t status) {
+  uint8_t end[6] = {BULK_EVT_END, status, 0, 0, 0, 0};
+  uint8_t links = 0;
+  for (uint8_t i = 0; i < BLE_MAX_LINKS; i++) {
+    if (bleLinks[i].active && bleLinks[i].connHandle == conn_hdl) links |= (1 << i);
+  }
+  queueTelemetryAckTo(links, bulkChar, end, 6);
+}
+
+void handleBulkWrite(uint16_t conn_hdl, uint8_t* data, uint16_t len) {
+  if (len < 1) return;
+  uint8_t op = data[0];
+  bool busy = bulk.mode != BULK_IDLE;
+  bool ours = busy && bulk.connHandle == conn_hdl;
+
+  switch (op) {
+    case BULK_OP_READ: {
+      if (busy) { rejectBulkRequest(conn_hdl, BULK_STATUS_BUSY); return; }
+      if (!acquireControl(conn_hdl)) { rejectBulkRequest(conn_hdl, BULK_STATUS_BUSY); return; }
+      if (len < 4 || len - 3 >= BULK_PATH_MAX || !allowedBulkReadPath(data + 3, len - 3)) {
+        rejectBulkRequest(conn_hdl, BULK_STATUS_BAD_REQUEST);
+        return;
+      }
+      memcpy(bulk.path, data + 3, len - 3);
+      bulk.path[len - 3] = '\0';
+      if (!bulkFile.open(bulk.path, FILE_O_READ)) { rejectBulkRequest(conn_hdl, BULK_STATUS_NOT_FOUND); return; }
+      startBulkTransfer(BULK_READING, conn_hdl, data[1] | (data[2] << 8), bulkFile.size());
+      Serial.print("Bulk download: ");
+      Serial.print(bulk.path);
+      Serial.print(" (");
+      Serial.print(bulk.size);
+      Serial.println(" bytes)");
+      break;
+    }
+
+    case BULK_OP_TEST: {
+      if (busy) { rejectBulkRequest(conn_hdl, BULK_STATUS_BUSY); return; }
+      // Saturates the radio - only the controlling central may starve the others' telemetry
+      if (!acquireControl(conn_hdl)) { rejectBulkRequest(conn_hdl, BULK_STATUS_BUSY); return; }
+      if (len < 4 || data[1] == 0) { rejectBulkRequest(conn_hdl, BULK_STATUS_BAD_REQUEST); return; }
+      uint8_t seconds = min(data[1], (uint8_t)BULK_TEST_MAX_SECONDS);
+      startBulkTransfer(BULK_TESTING, conn_hdl, data[2] | (data[3] << 8), 0xFFFFFFFF);
+      bulk.testEndMs = millis() + seconds * 1000UL;
+      Serial.print("Bulk throughput test: ");
+      Serial.print(seconds);
+      Serial.println("s");
+      break;
+    }
+
+    case BULK_OP_WRITE: {
+      if (busy) { rejectBulkRequest(conn_hdl, BULK_STATUS_BUSY); return; }
+      if (!acquireControl(conn_hdl)) { rejectBulkRequest(conn_hdl, BULK_STATUS_BUSY); return; }
+      uint16_t nameLen = len - 5;
+      uint32_t size = len < 6 ? 0 : data[1] | (data[2] << 8) | ((uint32_t)data[3] << 16) | ((uint32_t)data[4] << 24);
+      if (size == 0 || nameLen + sizeof(BULK_ASSET_DIR) + 1 > BULK_PATH_MAX || !validBulkName(data + 5, nameLen)) {
+        rejectBulkRequest(conn_hdl, BULK_STATUS_BAD_REQUEST);  // Empty uploads would never see a DATA frame
+        return;
+      }
+      snprintf(bulk.path, BULK_PATH_MAX, "%s/%.*s", BULK_ASSET_DIR, nameLen, (const char*)(data + 5));
+      InternalFS.remove(bulk.path);  // FILE_O_WRITE appends
+      if (!bulkFile.open(bulk.path, FILE_O_WRITE)) { rejectBulkRequest(conn_hdl, BULK_STATUS_FLASH_ERROR); return; }
+      startBulkTransfer(BULK_WRITING, conn_hdl, 0, size);
+      bulk.creditGrant = BULK_UPLOAD_WINDOW;
+      Serial.print("Bulk upload: ");
+      Serial.print(bulk.path);
+      Serial.print(" (");
+      Serial.print(size);
+      Serial.println(" bytes)");
+      break;
+    }
+
+    case BULK_OP_DATA:
+      if (!ours || bulk.mode != BULK_WRITING || bulk.finishing) return;
+      if (bulk.bytes + (len - 1) > bulk.size) {
+        endBulkTransfer(BULK_STATUS_BAD_REQUEST);
+        return;
+      }
+      if (bulkFile.write(data + 1, len - 1) != (size_t)(len - 1)) {
+        endBulkTransfer(BULK_STATUS_FLASH_ERROR);
+        return;
+      }
+      bulk.bytes += len - 1;
+      bulk.frames++;
+      noteLinkStreaming(conn_hdl);
+      if (bulk.bytes == bulk.size) {
+        endBulkTransfer(BULK_STATUS_OK);
+      } else {
+        bulk.creditGrant++;  // Frame is in flash - the central may send another
+      }
+      break;
+
+    case BULK_OP_CREDIT:
+      if (ours && len >= 3) {
+        bulk.credits = min(0xFFFFUL, (unsigned long)bulk.credits + (data[1] | (data[2] << 8)));
+      }
+      break;
+
+    case BULK_OP_ABORT:
+      if (ours && !bulk.finishing) {
+        endBulkTransfer(BULK_STATUS_ABORTED);
+      }
+      break;
+  }
+}
+
+// Called from serviceTelemetryTx() every pass: control frames first, then data while the
+// central has granted credits and the SoftDevice has buffers to spare
+void serviceBulkTransfer() {
+  if (bulk.mode == BULK_IDLE) return;
+  BleLink* link = findLink(bulk.connHandle);
+  if (!link || !bulkChar.notifyEnabled(link->connHandle)) return;
+
+  while (link->credits > BULK_RESERVED_CREDITS) {
+    if (bulk.controlLen > 0) {
+      if (!sendTelemetry(*link, bulkChar, bulk.control, bulk.controlLen)) return;
+      bulk.controlLen = 0;
+
+      if (bulk.finishing && bulk.resultPending) {
+        // Follow END with the throughput result
+        const BulkTestResult& result = bulk.results[0];
+        uint8_t report[12] = {BULK_EVT_RESULT,
+                              (uint8_t)(result.bytes >> 0), (uint8_t)(result.bytes >> 8),
+                              (uint8_t)(result.bytes >> 16), (uint8_t)(result.bytes >> 24),
+                              (uint8_t)(result.ms >> 0), (uint8_t)(result.ms >> 8),
+                              (uint8_t)(result.ms >> 16), (uint8_t)(result.ms >> 24),
+                              (uint8_t)(result.mtu & 0xFF), (uint8_t)(result.mtu >> 8), result.phy};
+        queueBulkControl(report, 12);
+        bulk.resultPending = false;
+        continue;
+      }
+      if (bulk.finishing) {
+        bulk.mode = BULK_IDLE;
+        bulk.finishing = false;
+        return;
+      }
+      continue;
+    }
+
+    if (bulk.creditGrant > 0) {
+      uint8_t grant[3] = {BULK_EVT_CREDIT, (uint8_t)(bulk.creditGrant & 0xFF), (uint8_t)(bulk.creditGrant >> 8)};
+      if (!sendTelemetry(*link, bulkChar, grant, 3)) return;
+      bulk.creditGrant = 0;
+      continue;
+    }
+
+    if (bulk.finishing || bulk.mode == BULK_WRITING) return;
+
+    if (bulk.mode == BULK_TESTING && (long)(millis() - bulk.testEndMs) >= 0) {
+      endBulkTransfer(BULK_STATUS_OK);
+      continue;
+    }
+    if (bulk.mode == BULK_READING && bulk.bytes >= bulk.size) {
+      endBulkTransfer(BULK_STATUS_OK);
+      continue;
+    }
+    if (bulk.credits == 0) {
+      bulk.creditStalls++;
+      return;
+    }
+
+    uint8_t frame[BLE_PREFERRED_MTU - 3];
+    uint16_t payload = bulkFramePayload(link->connHandle);
+    if (bulk.mode == BULK_READING) {
+      payload = min((uint32_t)payload, bulk.size - bulk.bytes);
+      uint32_t position = bulkFile.position();
+      if (bulkFile.read(frame + BULK_FRAME_HEADER, payload) != payload) {
+        endBulkTransfer(BULK_STATUS_FLASH_ERROR);
+        continue;
+      }
+      frame[0] = BULK_EVT_DATA;
+      frame[1] = bulk.sequence;
+      if (!sendTelemetry(*link, bulkChar, frame, BULK_FRAME_HEADER + payload)) {
+        bulkFile.seek(position);  // Resend the same chunk next pass
+        return;
+      }
+    } else {
+      frame[0] = BULK_EVT_DATA;
+      frame[1] = bulk.sequence;
+      for (uint16_t i = 0; i < payload; i++) {
+        frame[BULK_FRAME_HEADER + i] = (uint8_t)(bulk.bytes + i);  // Verifiable counter pattern
+      }
+      if (!sendTelemetry(*link, bulkChar, frame, BULK_FRAME_HEADER + payload)) return;
+    }
+
+    bulk.sequence++;
+    bulk.bytes += payload;
+    bulk.credits--;
+    bulk.frames++;
+    if (bulk.mode == BULK_TESTING || (bulk.frames & 0x0F) == 0) {
+      noteLinkStreaming(link->connHandle);
+    }
+  }
+}
+
+void printBulkStatus() {
+  Serial.println("\n=== BULK TRANSFER ===");
+  static const char* modes[] = {"idle", "download", "upload", "throughput test"};
+  Serial.print("Mode:          ");
+  Serial.println(modes[bulk.mode]);
+  if (bulk.mode != BULK_IDLE) {
+    Serial.print("Progress:      ");
+    Serial.print(bulk.bytes);
+    if (bulk.mode != BULK_TESTING) {
+      Serial.print(" / ");
+      Serial.print(bulk.size);
+    }
+    Serial.print(" bytes | credits ");
+    Serial.println(bulk.credits);
+  }
+  Serial.print("Frames:        ");
+  Serial.print(bulk.frames);
+  Serial.print(" | credit stalls ");
+  Serial.println(bulk.creditStalls);
+
+  for (uint8_t i = 0; i < bulk.resultCount; i++) {
+    const BulkTestResult& result = bulk.results[i];
+    Serial.print("Test ");
+    Serial.print(i + 1);
+    Serial.print(": ");
+    Serial.print(result.bytes / (float)result.ms, 1);
+    Serial.print(" KB/s | MTU ");
+    Serial.print(result.mtu);
+    Serial.print(" | data length ");
+    Serial.print(result.dataLength);
+    Serial.print(" | PHY ");
+    Serial.print(result.phy == BLE_GAP_PHY_2MBPS ? "2M" : "1M");
+    Serial.print(" | interval ");
+    Serial.print(result.interval * 1.25f, 2);
+    Serial.println("ms");
+  }
+}
+
+// ============================================================================
+// PERSISTENT STORAGE (InternalFS)
+// ============================================================================
+
+bool loadBlob(const char* path, void* data, uint16_t len) {
+  File file(InternalFS);
+  if (!file.open(path, FILE_O_READ)) {
+    return false;
+  }
+  bool ok = file.read(data, len) == len;
+  file.close();
+  return ok;
+}
+
+bool saveBlob(const char* path, const void* data, uint16_t len) {
+  // FILE_O_WRITE appends - replace the old record
+  InternalFS.remove(path);
+
+  File file(InternalFS);
+  if (!file.open(path, FILE_O_WRITE)) {
+    Serial.print("ERROR: Cannot write ");
+    Serial.println(path);
+    return false;
+  }
+  bool ok = file.write((const uint8_t*)data, len) == len;
+  file.close();
+  return ok;
 }
 
 // ============================================================================
@@ -1595,9 +5766,7 @@ void updateBatteryLevel() {
     lastBatteryLevel = batteryLevel;
 
     batteryLevelChar.write8(batteryLevel);
-    if (Bluefruit.connected()) {
-      batteryLevelChar.notify8(batteryLevel);
-    }
+    queueTelemetryValue(TX_SLOT_BATTERY, batteryLevelChar, &batteryLevel, 1);
     updateDeviceStatus();
 
     Serial.print("Battery: ");
@@ -179,6 +179,9 @@ void AudioI2S::playTone(uint16_t frequency, uint16_t duration_ms, uint8_t volume
         return;
     }
 
+    // Blocking playback would fight the queue for the peripheral
+    flush();
+
     // Clamp duration to prevent excessive blocking
     duration_ms = constrain(duration_ms, 1, MAX_TONE_DURATION_MS);
 
@@ -222,6 +225,77 @@ void AudioI2S::playMelody(const uint16_t* frequencies, const uint16_t* durations
     }
 }
 
+bool AudioI2S::queueTone(uint16_t frequency, uint16_t duration_ms, uint8_t volume, uint16_t gap_ms) {
+    if (!initialized || noteCount == AUDIO_NOTE_QUEUE_LEN) {
+        return false;
+    }
+
+    AudioNote& note = notes[(noteHead + noteCount) % AUDIO_NOTE_QUEUE_LEN];
+    note.frequency = frequency;
+    note.durationMs = constrain(duration_ms, 1, MAX_TONE_DURATION_MS);
+    note.gapMs = gap_ms;
+    note.volume = volume;
+    noteCount++;
+    playing = true;
+    return true;
+}
+
+void AudioI2S::flush() {
+    noteCount = 0;
+    if (queueState == QUEUE_TONE || queueState == QUEUE_STOPPING) {
+        stop();
+    }
+    queueState = QUEUE_IDLE;
+    playing = false;
+}
+
+void AudioI2S::update() {
+    switch (queueState) {
+        case QUEUE_IDLE:
+            if (noteCount == 0) {
+                return;
+            }
+            phaseEndsAt = millis() + notes[noteHead].gapMs;
+            queueState = QUEUE_GAP;
+            // Fall through - a note without a gap starts in this pass
+
+        case QUEUE_GAP: {
+            if ((long)(millis() - phaseEndsAt) < 0) {
+                return;
+            }
+            const AudioNote& note = notes[noteHead];
+            generateTone(note.frequency, AUDIO_BUFFER_SIZE, note.volume);
+            startTransfer(AUDIO_BUFFER_SIZE);
+            phaseEndsAt = millis() + note.durationMs;
+            queueState = QUEUE_TONE;
+            return;
+        }
+
+        case QUEUE_TONE:
+            if ((long)(millis() - phaseEndsAt) < 0) {
+                return;
+            }
+            NRF_I2S->TASKS_STOP = 1;
+            phaseEndsAt = millis() + 100;  // STOPPED timeout, as in waitForCompletion()
+            queueState = QUEUE_STOPPING;
+            return;
+
+        case QUEUE_STOPPING:
+            if (NRF_I2S->EVENTS_STOPPED == 0 && (long)(millis() - phaseEndsAt) < 0) {
+                return;
+            }
+            if (NRF_I2S->EVENTS_STOPPED == 0) {
+                Serial.println("ERROR: I2S STOPPED timeout!");
+            }
+            NRF_I2S->EVENTS_STOPPED = 0;
+            noteHead = (noteHead + 1) % AUDIO_NOTE_QUEUE_LEN;
+            noteCount--;
+            queueState = QUEUE_IDLE;
+            playing = noteCount > 0;
+            return;
+    }
+}
+
 void AudioI2S::startTransfer(uint16_t sampleCount) {
     // Set buffer pointer
     NRF_I2S->TXD.PTR = (uint32_t)audioBuffer;
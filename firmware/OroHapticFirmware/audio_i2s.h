@@ -38,6 +38,17 @@
 #define SAMPLE_RATE 16000           // 16kHz sample rate
 #define AUDIO_BUFFER_SIZE 256       // Sample buffer size (adjust for memory vs latency)
 #define MAX_TONE_DURATION_MS 2000   // Maximum tone duration to prevent blocking
+#define AUDIO_NOTE_QUEUE_LEN 8      // Queued notes for non-blocking playback (update())
+
+/**
+ * One queued note: silence for gapMs, then the tone
+ */
+struct AudioNote {
+    uint16_t frequency;
+    uint16_t durationMs;
+    uint16_t gapMs;
+    uint8_t volume;
+};
 
 class AudioI2S {
 public:
@@ -64,6 +75,27 @@ public:
      */
     void playMelody(const uint16_t* frequencies, const uint16_t* durations, uint8_t count, uint8_t volume);
 
+    /**
+     * Queue a tone for non-blocking playback - update() plays it
+     * @param frequency Frequency in Hz
+     * @param duration_ms Duration in milliseconds
+     * @param volume Volume level (0-100)
+     * @param gap_ms Silence before the tone starts
+     * @return false if the queue is full
+     */
+    bool queueTone(uint16_t frequency, uint16_t duration_ms, uint8_t volume, uint16_t gap_ms = 0);
+
+    /**
+     * Drop queued notes and stop the current one
+     */
+    void flush();
+
+    /**
+     * Advance queued playback - call from loop(). The 256-sample buffer repeats in
+     * hardware (TXD.PTR is left unchanged), so only note boundaries need the CPU.
+     */
+    void update();
+
     /**
      * Stop I2S playback and disable peripheral
      */
@@ -90,6 +122,14 @@ private:
     bool initialized = false;
     bool playing = false;
 
+    // Non-blocking note queue (update())
+    enum QueueState { QUEUE_IDLE, QUEUE_GAP, QUEUE_TONE, QUEUE_STOPPING };
+    AudioNote notes[AUDIO_NOTE_QUEUE_LEN];
+    uint8_t noteHead = 0;
+    uint8_t noteCount = 0;
+    QueueState queueState = QUEUE_IDLE;
+    unsigned long phaseEndsAt = 0;
+
     /**
      * Configure nRF52840 I2S peripheral registers
      */
@@ -0,0 +1,680 @@
+/*
+ * DRV2605L Haptic Sequencer Driver Implementation
+ *
+ * Register access goes straight through Wire so a whole cue chain can be
+ * written as one I2C burst. Register addresses come from Adafruit_DRV2605.h.
+ * All writes pass through the shadow register cache.
+ */
+
+#include "haptic_drv2605.h"
+#include <Wire.h>
+#include <Adafruit_DRV2605.h>
+#include <nrf.h>
+#include <nrf_soc.h>
+
+// CONTROL3 DATA_FORMAT_RTP: 1 = unsigned RTP input (0x00 = off, 0xFF = full drive)
+#define DRV2605_CONTROL3_RTP_UNSIGNED 0x08
+#define DRV2605_CONTROL3_LRA_OPEN_LOOP 0x01
+
+// FEEDBACK (0x1A) fields
+#define DRV2605_FEEDBACK_LRA 0x80           // N_ERM_LRA: 1 = LRA
+#define DRV2605_FEEDBACK_BRAKE_4X (3 << 4)  // FB_BRAKE_FACTOR: 4x braking
+#define DRV2605_FEEDBACK_LOOP_MEDIUM (1 << 2)
+#define DRV2605_FEEDBACK_BEMF_GAIN_LRA 0x02 // Starting point; auto-calibration refines it
+
+// CONTROL1 / CONTROL2 / CONTROL4 fields
+#define DRV2605_CONTROL1_STARTUP_BOOST 0x80
+#define DRV2605_CONTROL2_LRA 0xF5           // BIDIR_INPUT, BRAKE_STABILIZER, 300us sample, default blanking
+#define DRV2605_CONTROL4_AUTOCAL_1000MS (3 << 4)
+#define DRV2605_STATUS_DIAG_RESULT 0x08     // 1 = auto-calibration failed
+
+#define DRV2605_LIBRARY_ERM 1
+#define DRV2605_LIBRARY_LRA 6
+
+// TIMER4 is free on the Adafruit nRF52 core (SoftDevice owns TIMER0)
+#define HAPTIC_RTP_TIMER NRF_TIMER4
+#define HAPTIC_RTP_TIMER_IRQn TIMER4_IRQn
+#define HAPTIC_RTP_IRQ_PRIORITY 3  // Application priority (SoftDevice reserves 0, 1 and 4)
+
+// TIMER3 times the IN/TRIG edge; it only feeds PPI, no interrupt is used
+#define HAPTIC_TRIG_TIMER NRF_TIMER3
+
+// Instance driven by the TIMER4 ISR
+static HapticDRV2605* rtpOwner = nullptr;
+
+extern "C" void TIMER4_IRQHandler(void) {
+    if (HAPTIC_RTP_TIMER->EVENTS_COMPARE[0]) {
+        HAPTIC_RTP_TIMER->EVENTS_COMPARE[0] = 0;
+        if (rtpOwner) {
+            rtpOwner->onRtpTick();
+        }
+    }
+}
+
+bool HapticDRV2605::begin() {
+    Wire.beginTransmission(HAPTIC_I2C_ADDR);
+    if (Wire.endTransmission() != 0) {
+        Serial.println("ERROR: DRV2605L not responding for sequencer");
+        return false;
+    }
+
+    // Mirror the configuration Adafruit_DRV2605 left in the device
+    primeShadow();
+
+    // Start from an empty, stopped sequencer
+    writeRegister(DRV2605_REG_GO, 0);
+
+    // Unsigned RTP data so envelope amplitudes map directly to drive level
+    int control3 = readRegister(DRV2605_REG_CONTROL3);
+    if (control3 >= 0) {
+        writeRegister(DRV2605_REG_CONTROL3, control3 | DRV2605_CONTROL3_RTP_UNSIGNED);
+    }
+    rtpOwner = this;
+
+    initialized = true;
+    busy = false;
+    return true;
+}
+
+bool HapticDRV2605::loadSequence(const uint8_t* entries, uint8_t count) {
+    if (!initialized || count == 0) {
+        return false;
+    }
+
+    if (count > HAPTIC_SEQ_SLOTS) {
+        Serial.println("WARNING: Haptic sequence truncated to 8 slots");
+        count = HAPTIC_SEQ_SLOTS;
+    }
+
+    // Compile into slots - an unused slot of 0 terminates the sequence
+    uint8_t slots[HAPTIC_SEQ_SLOTS] = {0};
+    memcpy(slots, entries, count);
+
+    // A new pattern replaces whatever is playing
+    if (rtpActive) {
+        endRtp();
+    } else if (busy) {
+        writeRegister(DRV2605_REG_GO, 0);
+    }
+
+    // All slots (including the terminator) in one burst
+    if (!writeRegisters(DRV2605_REG_WAVESEQ1, slots, HAPTIC_SEQ_SLOTS)) {
+        Serial.println("ERROR: Haptic sequence write failed");
+        return false;
+    }
+    return true;
+}
+
+bool HapticDRV2605::playSequence(const uint8_t* entries, uint8_t count) {
+    if (autoCalState == HAPTIC_AUTOCAL_RUNNING) {
+        return false;  // The device is in auto-calibration mode
+    }
+    if (hwTrigger) {
+        return scheduleSequence(entries, count, 0);
+    }
+
+    if (!loadSequence(entries, count)) {
+        return false;
+    }
+
+    // A single GO starts the whole chain
+    if (!writeRegister(DRV2605_REG_GO, 1)) {
+        Serial.println("ERROR: Haptic GO write failed");
+        return false;
+    }
+
+    busy = true;
+    startedAt = millis();
+    lastPoll = startedAt;
+    return true;
+}
+
+bool HapticDRV2605::scheduleSequence(const uint8_t* entries, uint8_t count, uint32_t delayUs) {
+    if (!hwTrigger) {
+        Serial.println("ERROR: Hardware trigger not configured");
+        return false;
+    }
+    if (autoCalState == HAPTIC_AUTOCAL_RUNNING) {
+        return false;
+    }
+
+    // Cancel an armed edge that has not fired yet
+    HAPTIC_TRIG_TIMER->TASKS_STOP = 1;
+
+    if (!loadSequence(entries, count)) {
+        return false;
+    }
+
+    armTrigger(delayUs);
+
+    // GO polling starts once the edge has fired
+    busy = true;
+    startedAt = millis() + delayUs / 1000;
+    lastPoll = startedAt;
+    return true;
+}
+
+bool HapticDRV2605::beginHardwareTrigger(uint8_t gpio) {
+    if (!initialized) {
+        return false;
+    }
+
+    // GPIOTE task channel owns the pin, idle low
+    NRF_GPIOTE->CONFIG[HAPTIC_TRIG_GPIOTE_CH] =
+        (GPIOTE_CONFIG_MODE_Task << GPIOTE_CONFIG_MODE_Pos) |
+        ((uint32_t)(gpio & 0x1F) << GPIOTE_CONFIG_PSEL_Pos) |
+        ((uint32_t)(gpio >> 5) << GPIOTE_CONFIG_PORT_Pos) |
+        (GPIOTE_CONFIG_POLARITY_Toggle << GPIOTE_CONFIG_POLARITY_Pos) |
+        (GPIOTE_CONFIG_OUTINIT_Low << GPIOTE_CONFIG_OUTINIT_Pos);
+
+    // TIMER3 at 1MHz: COMPARE[0] raises the pin, COMPARE[1] drops it and stops the timer
+    HAPTIC_TRIG_TIMER->TASKS_STOP = 1;
+    HAPTIC_TRIG_TIMER->MODE = TIMER_MODE_MODE_Timer;
+    HAPTIC_TRIG_TIMER->BITMODE = TIMER_BITMODE_BITMODE_32Bit;
+    HAPTIC_TRIG_TIMER->PRESCALER = 4;  // 16MHz / 2^4 = 1MHz (1us ticks)
+    HAPTIC_TRIG_TIMER->SHORTS = TIMER_SHORTS_COMPARE1_STOP_Msk | TIMER_SHORTS_COMPARE1_CLEAR_Msk;
+
+    // PPI is owned by the SoftDevice while BLE is enabled - go through its API
+    if (sd_ppi_channel_assign(HAPTIC_TRIG_PPI_SET,
+                              &HAPTIC_TRIG_TIMER->EVENTS_COMPARE[0],
+                              &NRF_GPIOTE->TASKS_SET[HAPTIC_TRIG_GPIOTE_CH]) != NRF_SUCCESS ||
+        sd_ppi_channel_assign(HAPTIC_TRIG_PPI_CLR,
+                              &HAPTIC_TRIG_TIMER->EVENTS_COMPARE[1],
+                              &NRF_GPIOTE->TASKS_CLR[HAPTIC_TRIG_GPIOTE_CH]) != NRF_SUCCESS ||
+        sd_ppi_channel_enable_set((1UL << HAPTIC_TRIG_PPI_SET) | (1UL << HAPTIC_TRIG_PPI_CLR)) != NRF_SUCCESS) {
+        Serial.println("ERROR: Haptic trigger PPI setup failed");
+        return false;
+    }
+
+    // Rising edge on IN/TRIG now starts the sequencer
+    triggerMode = DRV2605_MODE_EXTTRIGEDGE;
+    if (!writeRegister(DRV2605_REG_MODE, triggerMode)) {
+        Serial.println("ERROR: Haptic external trigger mode failed");
+        return false;
+    }
+
+    hwTrigger = true;
+    return true;
+}
+
+bool HapticDRV2605::hardwareTriggerEnabled() {
+    return hwTrigger;
+}
+
+bool HapticDRV2605::triggerFired() {
+    return hwTrigger && HAPTIC_TRIG_TIMER->EVENTS_COMPARE[0] != 0;
+}
+
+bool HapticDRV2605::configureActuator(HapticActuator type) {
+    if (!initialized) {
+        return false;
+    }
+
+    stop();
+
+    int feedback = readRegister(DRV2605_REG_FEEDBACK);
+    int control1 = readRegister(DRV2605_REG_CONTROL1);
+    int control3 = readRegister(DRV2605_REG_CONTROL3);
+    if (feedback < 0 || control1 < 0 || control3 < 0) {
+        return false;
+    }
+
+    bool ok = true;
+    if (type == HAPTIC_ACTUATOR_LRA) {
+        // Drive time is half the resonance period (DRIVE_TIME * 0.1ms + 0.5ms)
+        uint32_t halfPeriodUs = 500000UL / HAPTIC_LRA_RESONANCE_HZ;
+        uint8_t driveTime = (uint8_t)constrain(((long)halfPeriodUs - 500) / 100, 0, 31);
+
+        ok &= writeRegister(DRV2605_REG_RATEDV, HAPTIC_LRA_RATED_VOLTAGE);
+        ok &= writeRegister(DRV2605_REG_CLAMPV, HAPTIC_LRA_OD_CLAMP);
+        ok &= writeRegister(DRV2605_REG_FEEDBACK, DRV2605_FEEDBACK_LRA | DRV2605_FEEDBACK_BRAKE_4X |
+                                                  DRV2605_FEEDBACK_LOOP_MEDIUM | DRV2605_FEEDBACK_BEMF_GAIN_LRA);
+        ok &= writeRegister(DRV2605_REG_CONTROL1, DRV2605_CONTROL1_STARTUP_BOOST | driveTime);
+        ok &= writeRegister(DRV2605_REG_CONTROL2, DRV2605_CONTROL2_LRA);
+        // Closed-loop auto-resonance tracking
+        ok &= writeRegister(DRV2605_REG_CONTROL3, control3 & ~DRV2605_CONTROL3_LRA_OPEN_LOOP);
+        ok &= writeRegister(DRV2605_REG_LIBRARY, DRV2605_LIBRARY_LRA);
+    } else {
+        ok &= writeRegister(DRV2605_REG_FEEDBACK, feedback & ~DRV2605_FEEDBACK_LRA);
+        ok &= writeRegister(DRV2605_REG_LIBRARY, DRV2605_LIBRARY_ERM);
+    }
+
+    if (ok) {
+        actuatorType = type;
+    }
+    return ok;
+}
+
+bool HapticDRV2605::runAutoCalibration(HapticCalibration& result) {
+    if (!startAutoCalibration()) {
+        return false;
+    }
+    while (autoCalState == HAPTIC_AUTOCAL_RUNNING) {
+        delay(HAPTIC_POLL_INTERVAL_MS);
+        update();
+    }
+    return pollAutoCalibration(result) == HAPTIC_AUTOCAL_DONE;
+}
+
+bool HapticDRV2605::startAutoCalibration() {
+    if (!initialized || autoCalState == HAPTIC_AUTOCAL_RUNNING) {
+        return false;
+    }
+
+    stop();
+
+    int control4 = readRegister(DRV2605_REG_CONTROL4);
+    if (control4 >= 0) {
+        writeRegister(DRV2605_REG_CONTROL4, (control4 & ~0x30) | DRV2605_CONTROL4_AUTOCAL_1000MS);
+    }
+
+    // Auto-calibration mode, started with GO; the device clears GO when done
+    HAPTIC_TRIG_TIMER->TASKS_STOP = 1;
+    writeRegister(DRV2605_REG_MODE, DRV2605_MODE_AUTOCAL);
+    writeRegister(DRV2605_REG_GO, 1);
+
+    autoCalState = HAPTIC_AUTOCAL_RUNNING;
+    busy = true;
+    startedAt = millis();
+    lastPoll = startedAt;
+    return true;
+}
+
+HapticAutoCalState HapticDRV2605::pollAutoCalibration(HapticCalibration& result) {
+    HapticAutoCalState state = autoCalState;
+    if (state == HAPTIC_AUTOCAL_DONE || state == HAPTIC_AUTOCAL_FAILED) {
+        result = autoCalResult;
+        autoCalState = HAPTIC_AUTOCAL_IDLE;
+    }
+    return state;
+}
+
+void HapticDRV2605::finishAutoCalibration(bool done) {
+    // The device rewrote these - refresh the shadow copy from the bus
+    shadowValid &= ~((1ULL << DRV2605_REG_AUTOCALCOMP) | (1ULL << DRV2605_REG_AUTOCALEMP) |
+                     (1ULL << DRV2605_REG_FEEDBACK));
+    int status = readRegister(DRV2605_REG_STATUS);
+    int comp = readRegister(DRV2605_REG_AUTOCALCOMP);
+    int bemf = readRegister(DRV2605_REG_AUTOCALEMP);
+    int feedback = readRegister(DRV2605_REG_FEEDBACK);
+    int period = readRegister(DRV2605_REG_LRARESON);
+
+    writeRegister(DRV2605_REG_MODE, triggerMode);
+    busy = false;
+    lastDuration = millis() - startedAt;
+    autoCalState = HAPTIC_AUTOCAL_FAILED;
+
+    if (!done) {
+        Serial.println("ERROR: Haptic auto-calibration timed out");
+        return;
+    }
+    if (status < 0 || (status & DRV2605_STATUS_DIAG_RESULT) || comp < 0 || bemf < 0 || feedback < 0) {
+        Serial.println("ERROR: Haptic auto-calibration failed (check actuator wiring)");
+        return;
+    }
+
+    autoCalResult.compensation = comp;
+    autoCalResult.backEmf = bemf;
+    autoCalResult.feedback = feedback;
+    autoCalResult.lraPeriod = period < 0 ? 0 : period;
+    autoCalState = HAPTIC_AUTOCAL_DONE;
+}
+
+bool HapticDRV2605::applyCalibration(const HapticCalibration& cal) {
+    if (!initialized) {
+        return false;
+    }
+
+    // 0x18-0x1A are consecutive: one burst
+    uint8_t values[3] = {cal.compensation, cal.backEmf, cal.feedback};
+    return writeRegisters(DRV2605_REG_AUTOCALCOMP, values, 3);
+}
+
+HapticActuator HapticDRV2605::actuator() {
+    return actuatorType;
+}
+
+float HapticDRV2605::lraResonanceHz() {
+    if (actuatorType != HAPTIC_ACTUATOR_LRA) {
+        return 0.0f;
+    }
+
+    // LRA period = LRA_PERIOD * 98.46us (only valid while/after driving the actuator)
+    int period = readRegister(DRV2605_REG_LRARESON);
+    if (period <= 0) {
+        return 0.0f;
+    }
+    return 1000000.0f / (period * 98.46f);
+}
+
+void HapticDRV2605::armTrigger(uint32_t delayUs) {
+    if (delayUs == 0) {
+        delayUs = 1;  // Compare cannot match a cleared counter at 0
+    }
+
+    HAPTIC_TRIG_TIMER->TASKS_STOP = 1;
+    HAPTIC_TRIG_TIMER->TASKS_CLEAR = 1;
+    HAPTIC_TRIG_TIMER->EVENTS_COMPARE[0] = 0;
+    HAPTIC_TRIG_TIMER->EVENTS_COMPARE[1] = 0;
+    HAPTIC_TRIG_TIMER->CC[0] = delayUs;
+    HAPTIC_TRIG_TIMER->CC[1] = delayUs + HAPTIC_TRIG_PULSE_US;
+    HAPTIC_TRIG_TIMER->TASKS_START = 1;
+}
+
+bool HapticDRV2605::playEffect(uint8_t effect) {
+    return playSequence(&effect, 1);
+}
+
+bool HapticDRV2605::playEnvelope(const HapticEnvelopePoint* points, uint8_t count, uint8_t intensity) {
+    if (!initialized || count == 0 || autoCalState == HAPTIC_AUTOCAL_RUNNING) {
+        return false;
+    }
+
+    if (count > HAPTIC_RTP_MAX_POINTS) {
+        Serial.println("WARNING: Haptic envelope truncated to 16 points");
+        count = HAPTIC_RTP_MAX_POINTS;
+    }
+
+    if (rtpActive) {
+        endRtp();
+    } else if (busy) {
+        writeRegister(DRV2605_REG_GO, 0);
+    }
+
+    // Copy before the ISR can see it
+    memcpy(envelope, points, count * sizeof(HapticEnvelopePoint));
+    envelopeCount = count;
+    envelopeScale = constrain(intensity, 0, 100);
+    rtpSegment = 0;
+    rtpSegmentElapsedUs = 0;
+    rtpSegmentStart = 0;
+    rtpFinished = false;
+    rtpOverrunTicks = 0;
+
+    // First amplitude goes out immediately; the timer takes over from there
+    onRtpTick();
+    rtpLastWritten = rtpPendingValue;
+    rtpPending = false;
+    writeRegister(DRV2605_REG_RTPIN, rtpLastWritten);
+    rtpWrites++;
+
+    HAPTIC_TRIG_TIMER->TASKS_STOP = 1;  // An armed trigger edge must not fire into RTP
+
+    if (!writeRegister(DRV2605_REG_MODE, DRV2605_MODE_REALTIME)) {
+        Serial.println("ERROR: Haptic RTP mode switch failed");
+        return false;
+    }
+
+    rtpActive = true;
+    busy = true;
+    startedAt = millis();
+    startRtpTimer();
+    return true;
+}
+
+void HapticDRV2605::onRtpTick() {
+    // Skip past finished segments (zero-length segments are steps)
+    while (rtpSegment < envelopeCount &&
+           rtpSegmentElapsedUs >= (uint32_t)envelope[rtpSegment].durationMs * 1000UL) {
+        rtpSegmentElapsedUs -= (uint32_t)envelope[rtpSegment].durationMs * 1000UL;
+        rtpSegmentStart = envelope[rtpSegment].amplitude;
+        rtpSegment++;
+    }
+
+    uint8_t amplitude;
+    if (rtpSegment >= envelopeCount) {
+        amplitude = 0;
+        if (rtpFinished && rtpOverrunTicks < 0xFFFF) {
+            rtpOverrunTicks++;
+        }
+        rtpFinished = true;
+    } else {
+        const HapticEnvelopePoint& seg = envelope[rtpSegment];
+        uint32_t durationUs = (uint32_t)seg.durationMs * 1000UL;
+        int32_t delta = (int32_t)seg.amplitude - (int32_t)rtpSegmentStart;
+        amplitude = (uint8_t)(rtpSegmentStart + (delta * (int32_t)rtpSegmentElapsedUs) / (int32_t)durationUs);
+        rtpSegmentElapsedUs += HAPTIC_RTP_TICK_US;
+    }
+
+    rtpPendingValue = (uint8_t)(((uint16_t)amplitude * envelopeScale) / 100);
+    rtpPending = true;
+}
+
+void HapticDRV2605::startRtpTimer() {
+    HAPTIC_RTP_TIMER->TASKS_STOP = 1;
+    HAPTIC_RTP_TIMER->MODE = TIMER_MODE_MODE_Timer;
+    HAPTIC_RTP_TIMER->BITMODE = TIMER_BITMODE_BITMODE_32Bit;
+    HAPTIC_RTP_TIMER->PRESCALER = 4;  // 16MHz / 2^4 = 1MHz (1us ticks)
+    HAPTIC_RTP_TIMER->CC[0] = HAPTIC_RTP_TICK_US;
+    HAPTIC_RTP_TIMER->SHORTS = TIMER_SHORTS_COMPARE0_CLEAR_Msk;
+    HAPTIC_RTP_TIMER->EVENTS_COMPARE[0] = 0;
+    HAPTIC_RTP_TIMER->INTENSET = TIMER_INTENSET_COMPARE0_Msk;
+    NVIC_SetPriority(HAPTIC_RTP_TIMER_IRQn, HAPTIC_RTP_IRQ_PRIORITY);
+    NVIC_ClearPendingIRQ(HAPTIC_RTP_TIMER_IRQn);
+    NVIC_EnableIRQ(HAPTIC_RTP_TIMER_IRQn);
+    HAPTIC_RTP_TIMER->TASKS_CLEAR = 1;
+    HAPTIC_RTP_TIMER->TASKS_START = 1;
+}
+
+void HapticDRV2605::endRtp() {
+    HAPTIC_RTP_TIMER->TASKS_STOP = 1;
+    HAPTIC_RTP_TIMER->INTENCLR = TIMER_INTENSET_COMPARE0_Msk;
+    NVIC_DisableIRQ(HAPTIC_RTP_TIMER_IRQn);
+
+    rtpActive = false;
+    rtpPending = false;
+
+    // Zero the drive before leaving RTP so the motor does not hold the last level
+    writeRegister(DRV2605_REG_RTPIN, 0);
+    rtpLastWritten = 0;
+    writeRegister(DRV2605_REG_MODE, triggerMode);
+}
+
+void HapticDRV2605::stop() {
+    if (!initialized) return;
+
+    if (autoCalState == HAPTIC_AUTOCAL_RUNNING) {
+        return;  // Calibration runs to completion (update() ends it)
+    }
+
+    if (rtpActive) {
+        endRtp();
+    }
+    if (hwTrigger) {
+        HAPTIC_TRIG_TIMER->TASKS_STOP = 1;
+    }
+    writeRegister(DRV2605_REG_GO, 0);
+    busy = false;
+}
+
+void HapticDRV2605::update() {
+    if (!busy) return;
+
+    if (rtpActive) {
+        // Latch the amplitude computed by the timer ISR
+        if (rtpPending) {
+            uint8_t value = rtpPendingValue;
+            rtpPending = false;
+            if (value != rtpLastWritten) {
+                writeRegister(DRV2605_REG_RTPIN, value);
+                rtpLastWritten = value;
+                rtpWrites++;
+            }
+        }
+        if (rtpFinished) {
+            uint32_t overrun = (uint32_t)rtpOverrunTicks * HAPTIC_RTP_TICK_US;
+            if (overrun > rtpMaxOverrun) {
+                rtpMaxOverrun = overrun;
+            }
+            endRtp();
+            busy = false;
+            lastDuration = millis() - startedAt;
+        }
+        return;
+    }
+
+    unsigned long now = millis();
+    if ((long)(now - lastPoll) < HAPTIC_POLL_INTERVAL_MS) {
+        return;  // Also holds off polling until a scheduled trigger edge has fired
+    }
+    lastPoll = now;
+
+    // GO self-clears when the last slot finishes (or auto-calibration completes)
+    int go = readRegister(DRV2605_REG_GO);
+    if (autoCalState == HAPTIC_AUTOCAL_RUNNING) {
+        bool done = go >= 0 && (go & 0x01) == 0;
+        if (done || now - startedAt >= HAPTIC_AUTOCAL_TIMEOUT_MS) {
+            finishAutoCalibration(done);
+        }
+        return;
+    }
+    if (go >= 0 && (go & 0x01) == 0) {
+        busy = false;
+        lastDuration = now - startedAt;
+    }
+}
+
+bool HapticDRV2605::isBusy() {
+    return busy;
+}
+
+uint32_t HapticDRV2605::lastPlaybackMs() {
+    return lastDuration;
+}
+
+uint32_t HapticDRV2605::rtpWriteCount() {
+    return rtpWrites;
+}
+
+bool HapticDRV2605::rtpPlaying() {
+    return rtpActive;
+}
+
+uint32_t HapticDRV2605::rtpMaxOverrunUs() {
+    return rtpMaxOverrun;
+}
+
+const HapticBusStats& HapticDRV2605::busStats() {
+    return stats;
+}
+
+uint32_t HapticDRV2605::savedBusTimeUs() {
+    if (stats.bytes == 0) return 0;
+    return (uint32_t)(((uint64_t)stats.busTimeUs * stats.skippedBytes) / stats.bytes);
+}
+
+bool HapticDRV2605::isCacheable(uint8_t reg) {
+    switch (reg) {
+        case DRV2605_REG_STATUS:    // Diagnostic/overtemp flags set by the device
+        case DRV2605_REG_GO:        // Self-clearing trigger - every write must reach the device
+        case DRV2605_REG_VBAT:      // Live supply measurement
+        case DRV2605_REG_LRARESON:  // Live LRA period measurement
+            return false;
+        default:
+            return reg < HAPTIC_REG_COUNT;
+    }
+}
+
+void HapticDRV2605::primeShadow() {
+    shadowValid = 0;
+
+    // Burst read 0x01-0x20 (address auto-increments)
+    const uint8_t first = DRV2605_REG_MODE;
+    const uint8_t count = 0x20;
+    Wire.beginTransmission(HAPTIC_I2C_ADDR);
+    Wire.write(first);
+    if (Wire.endTransmission(false) != 0) {
+        return;
+    }
+    if (Wire.requestFrom((uint8_t)HAPTIC_I2C_ADDR, count) != count) {
+        return;
+    }
+    for (uint8_t i = 0; i < count; i++) {
+        uint8_t reg = first + i;
+        shadow[reg] = Wire.read();
+        if (isCacheable(reg)) {
+            shadowValid |= (1ULL << reg);
+        }
+    }
+}
+
+bool HapticDRV2605::busWrite(uint8_t reg, const uint8_t* values, uint8_t count) {
+    uint32_t start = micros();
+    Wire.beginTransmission(HAPTIC_I2C_ADDR);
+    Wire.write(reg);
+    Wire.write(values, count);
+    bool ok = Wire.endTransmission() == 0;
+
+    stats.busTimeUs += micros() - start;
+    stats.transactions++;
+    stats.bytes += 2 + count;  // Address byte + register byte + data
+    return ok;
+}
+
+bool HapticDRV2605::writeRegisters(uint8_t reg, const uint8_t* values, uint8_t count) {
+    // Trim to the span of registers whose shadow copy differs
+    int first = -1;
+    int last = -1;
+    for (uint8_t i = 0; i < count; i++) {
+        uint8_t r = reg + i;
+        bool known = isCacheable(r) && (shadowValid & (1ULL << r)) && shadow[r] == values[i];
+        if (!known) {
+            if (first < 0) first = i;
+            last = i;
+        }
+    }
+
+    if (first < 0) {
+        // Nothing changes - the whole transaction is elided
+        stats.skippedRegisters += count;
+        stats.skippedBytes += 2 + count;
+        return true;
+    }
+
+    uint8_t span = last - first + 1;
+    stats.skippedRegisters += count - span;
+    stats.skippedBytes += count - span;
+
+    if (!busWrite(reg + first, values + first, span)) {
+        // Device state unknown after a failed write
+        for (uint8_t i = first; i <= last; i++) {
+            shadowValid &= ~(1ULL << (reg + i));
+        }
+        return false;
+    }
+
+    for (uint8_t i = first; i <= last; i++) {
+        uint8_t r = reg + i;
+        if (isCacheable(r)) {
+            shadow[r] = values[i];
+            shadowValid |= (1ULL << r);
+        }
+    }
+    return true;
+}
+
+bool HapticDRV2605::writeRegister(uint8_t reg, uint8_t value) {
+    return writeRegisters(reg, &value, 1);
+}
+
+int HapticDRV2605::readRegister(uint8_t reg) {
+    if (isCacheable(reg) && (shadowValid & (1ULL << reg))) {
+        return shadow[reg];
+    }
+
+    Wire.beginTransmission(HAPTIC_I2C_ADDR);
+    Wire.write(reg);
+    if (Wire.endTransmission(false) != 0) {
+        return -1;
+    }
+    if (Wire.requestFrom((uint8_t)HAPTIC_I2C_ADDR, (uint8_t)1) != 1) {
+        return -1;
+    }
+
+    uint8_t value = Wire.read();
+    if (isCacheable(reg)) {
+        shadow[reg] = value;
+        shadowValid |= (1ULL << reg);
+    }
+    return value;
+}
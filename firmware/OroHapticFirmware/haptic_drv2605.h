@@ -0,0 +1,384 @@
+/*
+ * DRV2605L Haptic Sequencer Driver for Oro Haptic Paddle
+ *
+ * Hardware: nRF52840 + DRV2605L haptic driver (I2C address 0x5A)
+ *
+ * The DRV2605L has 8 waveform sequencer slots (registers 0x04-0x0B). Each slot holds
+ * either a library effect ID (1-123) or a wait entry (bit 7 set, 10ms units). A whole
+ * multi-effect cue is compiled into the slots, written in a single I2C burst (the
+ * device auto-increments the register address) and started with one GO write.
+ *
+ * The DRV2605L has no interrupt output, so completion is detected by polling the
+ * GO bit from update() - never with a blocking delay.
+ *
+ * Real-Time Playback (RTP): library effects have fixed amplitude, so intensity-scaled
+ * cues are streamed as amplitude envelopes to the RTP input register (0x02). TIMER4
+ * paces the envelope at 250 Hz; the ISR only computes the next amplitude, and update()
+ * performs the I2C write (Wire is not ISR-safe and the IMU shares the bus). The zero at
+ * the envelope's end is written by update() too, so the sketch holds back work that would
+ * block loop() while rtpPlaying(); rtpMaxOverrunUs() shows how late the zero went out.
+ *
+ * RTP bus budget: one single-register write is 3 bytes + start/stop, ~75us at 400kHz.
+ * At 250 Hz that is at most ~19ms of bus time per second (<2%), and unchanged
+ * amplitudes (holds) are not re-written.
+ *
+ * Hardware trigger (optional): with IN/TRIG wired to a GPIO the DRV2605L runs in
+ * external edge-trigger mode. TIMER3 compare events drive GPIOTE set/clear tasks
+ * through PPI, so the trigger edge fires at a microsecond-exact time no matter what
+ * the CPU or the shared I2C bus is doing. The sequencer slots are loaded over I2C
+ * ahead of time; only the edge is time-critical.
+ *
+ * Actuators: ERM (open loop, ROM library 1) or LRA (ROM library 6, closed-loop
+ * auto-resonance tracking, 4x braking factor with brake stabilizer). LRA mode needs
+ * the DRV2605L auto-calibration; its results (A_CAL_COMP, A_CAL_BEMF, BEMF gain) are
+ * returned so the sketch can persist them and re-apply them at boot.
+ *
+ * Shadow registers: every writable register is mirrored in RAM and writes that would
+ * not change device state are skipped. Replaying the same cue costs a single GO write;
+ * a changed cue rewrites only the span of slots that differ. Self-clearing and
+ * device-updated registers (STATUS, GO, VBAT, LRA period) are never cached.
+ *
+ * Library selection and mode setup are still done through Adafruit_DRV2605 before
+ * begin() is called; begin() then primes the shadow copy from the device.
+ */
+
+#ifndef HAPTIC_DRV2605_H
+#define HAPTIC_DRV2605_H
+
+#include <Arduino.h>
+
+#define HAPTIC_I2C_ADDR 0x5A
+
+// Waveform sequencer configuration
+#define HAPTIC_SEQ_SLOTS 8            // Sequencer slots available on the DRV2605L
+#define HAPTIC_WAIT_UNIT_MS 10        // Wait entries count in 10ms steps
+#define HAPTIC_WAIT_MAX_MS 1270       // Longest wait a single slot can encode
+#define HAPTIC_POLL_INTERVAL_MS 5     // How often update() reads the GO bit while playing
+
+// Encode a sequencer wait entry (bit 7 set, 7-bit wait time in 10ms units)
+#define HAPTIC_WAIT(ms) ((uint8_t)(0x80 | (((ms) / HAPTIC_WAIT_UNIT_MS) > 0x7F ? 0x7F : ((ms) / HAPTIC_WAIT_UNIT_MS))))
+
+// True if a sequencer entry is a wait rather than an effect
+#define HAPTIC_IS_WAIT(entry) (((entry) & 0x80) != 0)
+
+// Real-time playback configuration
+#define HAPTIC_RTP_MAX_POINTS 16      // Envelope points per RTP cue
+#define HAPTIC_RTP_TICK_US 4000       // Envelope update period (250 Hz)
+
+// Shadowed register map (0x00-0x22)
+#define HAPTIC_REG_COUNT 0x23
+
+// Hardware trigger configuration (TIMER3 -> PPI -> GPIOTE -> IN/TRIG)
+#define HAPTIC_TRIG_PULSE_US 20       // IN/TRIG high time per trigger edge
+#define HAPTIC_TRIG_GPIOTE_CH 0       // GPIOTE channel driving IN/TRIG
+#define HAPTIC_TRIG_PPI_SET 10        // PPI channel: TIMER3 COMPARE[0] -> GPIOTE SET
+#define HAPTIC_TRIG_PPI_CLR 11        // PPI channel: TIMER3 COMPARE[1] -> GPIOTE CLR
+
+// LRA drive defaults - for a 2.0 Vrms / 175 Hz coin LRA; adjust to the actuator datasheet.
+// Closed loop with SAMPLE_TIME 300us (CONTROL2): k = sqrt(1 - (4 * 300us + 300us) * 175 Hz) = 0.859
+//   RATED_VOLTAGE = Vrms / (20.58 mV * k)     -> 2.0 Vrms  = 113 = 0x71
+//   OD_CLAMP      = Vpeak / (21.96 mV * k)    -> 0xA4 = ~3.1 Vpeak (2.0 Vrms is 2.83 Vpeak)
+#define HAPTIC_LRA_RESONANCE_HZ 175
+#define HAPTIC_LRA_RATED_VOLTAGE 0x71   // RATED_VOLTAGE code for ~2.0 Vrms closed loop
+#define HAPTIC_LRA_OD_CLAMP 0xA4        // OD_CLAMP code for ~3.1 Vpeak overdrive
+#define HAPTIC_AUTOCAL_TIMEOUT_MS 2000  // AUTO_CAL_TIME is 1000-1200ms
+
+enum HapticActuator {
+    HAPTIC_ACTUATOR_ERM = 0,
+    HAPTIC_ACTUATOR_LRA = 1
+};
+
+enum HapticAutoCalState {
+    HAPTIC_AUTOCAL_IDLE = 0,
+    HAPTIC_AUTOCAL_RUNNING,     // GO set, polled from update()
+    HAPTIC_AUTOCAL_DONE,        // Result ready for pollAutoCalibration()
+    HAPTIC_AUTOCAL_FAILED
+};
+
+/**
+ * DRV2605L auto-calibration results (persisted by the sketch)
+ */
+struct HapticCalibration {
+    uint8_t compensation;   // A_CAL_COMP (0x18)
+    uint8_t backEmf;        // A_CAL_BEMF (0x19)
+    uint8_t feedback;       // FEEDBACK (0x1A), including the calibrated BEMF_GAIN
+    uint8_t lraPeriod;      // LRA_PERIOD (0x22) measured after calibration
+};
+
+/**
+ * I2C bus accounting for the haptic driver
+ */
+struct HapticBusStats {
+    uint32_t transactions;      // I2C write transactions issued
+    uint32_t bytes;             // Bytes on the bus, including address and register bytes
+    uint32_t busTimeUs;         // Time spent inside write transactions
+    uint32_t skippedRegisters;  // Register writes elided by the shadow cache
+    uint32_t skippedBytes;      // Bus bytes those writes would have cost
+};
+
+/**
+ * One RTP envelope segment: ramp linearly from the current amplitude to
+ * `amplitude` over `durationMs` (0 = step). Equal consecutive amplitudes hold.
+ */
+struct HapticEnvelopePoint {
+    uint8_t amplitude;    // 0-255 unsigned RTP drive level
+    uint16_t durationMs;
+};
+
+class HapticDRV2605 {
+public:
+    /**
+     * Attach to an already configured DRV2605L
+     * @return true if the device acknowledges on the I2C bus
+     */
+    bool begin();
+
+    /**
+     * Compile a cue chain into the sequencer slots and start it with a single GO
+     * @param entries Effect IDs (1-123) and HAPTIC_WAIT(ms) entries, played in order
+     * @param count Number of entries (max HAPTIC_SEQ_SLOTS)
+     * @return true if the pattern was written and triggered
+     */
+    bool playSequence(const uint8_t* entries, uint8_t count);
+
+    /**
+     * Play a single library effect (one-slot sequence)
+     * @param effect DRV2605L library effect ID
+     * @return true if the effect was triggered
+     */
+    bool playEffect(uint8_t effect);
+
+    /**
+     * Load a cue chain now and fire it from the hardware trigger after a delay
+     * @param entries Effect IDs and HAPTIC_WAIT(ms) entries
+     * @param count Number of entries (max HAPTIC_SEQ_SLOTS)
+     * @param delayUs Microseconds until the trigger edge (0 = as soon as possible)
+     * @return true if the cue was loaded and the trigger armed
+     */
+    bool scheduleSequence(const uint8_t* entries, uint8_t count, uint32_t delayUs);
+
+    /**
+     * Switch to external edge-trigger mode with IN/TRIG wired to a GPIO
+     * @param gpio nRF52840 GPIO number (not the Arduino D-number)
+     * @return true if the trigger path was configured
+     */
+    bool beginHardwareTrigger(uint8_t gpio);
+
+    /**
+     * Check if triggers go through the IN/TRIG pin instead of the GO register
+     */
+    bool hardwareTriggerEnabled();
+
+    /**
+     * Check if the last armed trigger edge has fired (TIMER3 COMPARE[0] latch, cleared
+     * when a trigger is armed; stays clear if the edge was cancelled by stop())
+     */
+    bool triggerFired();
+
+    /**
+     * Select the actuator type: library, feedback loop and braking configuration
+     * @param type HAPTIC_ACTUATOR_ERM or HAPTIC_ACTUATOR_LRA
+     * @return true if the device accepted the configuration
+     */
+    bool configureActuator(HapticActuator type);
+
+    /**
+     * Run the DRV2605L auto-calibration (blocks ~1.2s - call only while idle)
+     * @param result Calibration values read back from the device
+     * @return true if calibration completed and DIAG_RESULT reports success
+     */
+    bool runAutoCalibration(HapticCalibration& result);
+
+    /**
+     * Start the auto-calibration without blocking; update() polls for completion
+     * and playback requests are refused until it ends
+     * @return true if calibration was started
+     */
+    bool startAutoCalibration();
+
+    /**
+     * Collect the result of startAutoCalibration()
+     * @param result Calibration values, valid when HAPTIC_AUTOCAL_DONE is returned
+     * @return HAPTIC_AUTOCAL_RUNNING while in progress; DONE or FAILED once, then IDLE
+     */
+    HapticAutoCalState pollAutoCalibration(HapticCalibration& result);
+
+    /**
+     * Apply previously stored calibration values
+     */
+    bool applyCalibration(const HapticCalibration& cal);
+
+    /**
+     * Currently configured actuator type
+     */
+    HapticActuator actuator();
+
+    /**
+     * LRA resonance frequency tracked by the auto-resonance loop
+     * @return Frequency in Hz, or 0 if unavailable / not an LRA
+     */
+    float lraResonanceHz();
+
+    /**
+     * Stream an amplitude envelope through Real-Time Playback mode
+     * @param points Envelope segments, played in order
+     * @param count Number of segments (max HAPTIC_RTP_MAX_POINTS)
+     * @param intensity Scale applied to every amplitude (0-100)
+     * @return true if RTP playback started
+     */
+    bool playEnvelope(const HapticEnvelopePoint* points, uint8_t count, uint8_t intensity);
+
+    /**
+     * Stop playback immediately (clears GO, ends RTP)
+     */
+    void stop();
+
+    /**
+     * Poll the GO bit to detect completion - call from loop()
+     */
+    void update();
+
+    /**
+     * Check if a sequence is currently playing (as of the last update() poll)
+     * @return true if playing, false otherwise
+     */
+    bool isBusy();
+
+    /**
+     * Duration of the last completed sequence, measured by GO polling
+     * @return Playback time in ms (resolution HAPTIC_POLL_INTERVAL_MS)
+     */
+    uint32_t lastPlaybackMs();
+
+    /**
+     * Number of RTP amplitude writes issued since boot (bus budget accounting)
+     */
+    uint32_t rtpWriteCount();
+
+    /**
+     * Check if an RTP envelope is streaming. The end-of-envelope zero is written by
+     * update(), so callers must not block loop() while this is true.
+     */
+    bool rtpPlaying();
+
+    /**
+     * Longest time the drive was held past an envelope's end before update() zeroed it
+     * @return Overrun in microseconds (resolution HAPTIC_RTP_TICK_US)
+     */
+    uint32_t rtpMaxOverrunUs();
+
+    /**
+     * I2C write accounting, including writes skipped by the shadow cache
+     */
+    const HapticBusStats& busStats();
+
+    /**
+     * Estimated bus time saved by the shadow cache, from the measured cost per byte
+     * @return Saved time in microseconds
+     */
+    uint32_t savedBusTimeUs();
+
+    /**
+     * Advance the envelope by one tick - called from the TIMER4 ISR only
+     */
+    void onRtpTick();
+
+private:
+    bool initialized = false;
+    bool busy = false;
+    unsigned long startedAt = 0;
+    unsigned long lastPoll = 0;
+    uint32_t lastDuration = 0;
+    bool hwTrigger = false;
+    HapticActuator actuatorType = HAPTIC_ACTUATOR_ERM;
+    uint8_t triggerMode = 0;          // Mode restored after RTP (internal or external edge)
+
+    // Non-blocking auto-calibration
+    HapticAutoCalState autoCalState = HAPTIC_AUTOCAL_IDLE;
+    HapticCalibration autoCalResult = {0, 0, 0, 0};
+
+    // RTP envelope state (shared with the TIMER4 ISR)
+    HapticEnvelopePoint envelope[HAPTIC_RTP_MAX_POINTS];
+    uint8_t envelopeCount = 0;
+    uint8_t envelopeScale = 100;
+    volatile bool rtpActive = false;
+    volatile bool rtpFinished = false;
+    volatile uint8_t rtpSegment = 0;
+    volatile uint32_t rtpSegmentElapsedUs = 0;
+    volatile uint8_t rtpSegmentStart = 0;
+    volatile uint8_t rtpPendingValue = 0;
+    volatile bool rtpPending = false;
+    volatile uint16_t rtpOverrunTicks = 0;  // Ticks after the envelope ended, before update() saw it
+    uint32_t rtpMaxOverrun = 0;
+    uint8_t rtpLastWritten = 0;
+    uint32_t rtpWrites = 0;
+
+    // Shadow copy of the device registers
+    uint8_t shadow[HAPTIC_REG_COUNT];
+    uint64_t shadowValid = 0;  // Bit per register: shadow matches the device
+    HapticBusStats stats = {0, 0, 0, 0, 0};
+
+    /**
+     * Whether a register can be served from / elided by the shadow copy
+     */
+    bool isCacheable(uint8_t reg);
+
+    /**
+     * Fill the shadow copy with one burst read of the device registers
+     */
+    void primeShadow();
+
+    /**
+     * Issue a write transaction and account for it (no cache check)
+     */
+    bool busWrite(uint8_t reg, const uint8_t* values, uint8_t count);
+
+    /**
+     * Load the sequencer slots (shadow-cached burst) without triggering
+     */
+    bool loadSequence(const uint8_t* entries, uint8_t count);
+
+    /**
+     * Arm TIMER3 to raise IN/TRIG after delayUs (PPI does the rest)
+     */
+    void armTrigger(uint32_t delayUs);
+
+    /**
+     * Configure TIMER4 to tick every HAPTIC_RTP_TICK_US
+     */
+    void startRtpTimer();
+
+    /**
+     * Stop TIMER4 and return the DRV2605L to its trigger mode
+     */
+    void endRtp();
+
+    /**
+     * Read back the auto-calibration results and return to the trigger mode
+     * @param done GO cleared before the timeout
+     */
+    void finishAutoCalibration(bool done);
+
+    /**
+     * Write consecutive registers in one I2C transaction (address auto-increment),
+     * trimmed to the span that differs from the shadow copy
+     * @param reg First register address
+     * @param values Register values
+     * @param count Number of registers
+     * @return true if the device acknowledged
+     */
+    bool writeRegisters(uint8_t reg, const uint8_t* values, uint8_t count);
+
+    /**
+     * Write a single register
+     */
+    bool writeRegister(uint8_t reg, uint8_t value);
+
+    /**
+     * Read a single register (from the shadow copy when cacheable)
+     * @return Register value, or -1 on bus error
+     */
+    int readRegister(uint8_t reg);
+};
+
+#endif // HAPTIC_DRV2605_H
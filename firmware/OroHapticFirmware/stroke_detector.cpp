@@ -0,0 +1,153 @@
+/*
+ * Stroke Phase Detector Implementation
+ *
+ * Thresholds are based on real paddle data: catch peak ~1.8g, finish crossing
+ * near 0g, recovery minimum ~-2.4g. Times are millisecond timestamps compared
+ * by unsigned difference, so a millis() wrap is harmless.
+ */
+
+#include "stroke_detector.h"
+
+static void recordCatchLead(StrokeDetector& detector, StrokeStep& step, uint32_t leadMs) {
+  CatchLatencyStats& stats = detector.stats;
+  uint16_t lead = leadMs > 0xFFFF ? 0xFFFF : (uint16_t)leadMs;
+  stats.leadSamples++;
+  stats.leadSumMs += lead;
+  if (lead < stats.leadMinMs) stats.leadMinMs = lead;
+  if (lead > stats.leadMaxMs) stats.leadMaxMs = lead;
+
+  step.leadMeasured = true;
+  step.leadMs = lead;
+}
+
+static void enterPhase(StrokeDetector& detector, StrokeStep& step, StrokePhase phase, uint32_t phaseTime) {
+  detector.currentPhase = phase;
+  step.transition = true;
+  step.phase = phase;
+  step.phaseTime = phaseTime;
+}
+
+void strokeDetectorReset(StrokeDetector& detector) {
+  detector.currentPhase = STROKE_PHASE_RECOVERY;
+  detector.lastStrokeTime = 0;
+  detector.maxAccel = 0.0;
+  detector.minAccel = 0.0;
+  detector.inStroke = false;
+  detector.prevGyroRate = 0.0;
+  detector.gyroArmed = false;
+  detector.gyroOnsetTime = 0;
+  detector.catchTime = 0;
+  detector.accelCatchPending = false;
+  detector.driveTime = 0;
+  detector.finishTime = 0;
+  detector.stats = {0, 0, 0, 0, 0, 0, 0xFFFF, 0};
+}
+
+void strokeDetectorReseed(StrokeDetector& detector, float gyroRate) {
+  detector.prevGyroRate = gyroRate;
+}
+
+StrokeStep strokeDetectorUpdate(StrokeDetector& detector, uint32_t timeMs,
+                                float strokeAccel, float gyroRate, float threshold) {
+  StrokeStep step = {false, detector.currentPhase, timeMs, false, false, 0};
+
+  float gyroRise = gyroRate - detector.prevGyroRate;
+  detector.prevGyroRate = gyroRate;
+
+  switch (detector.currentPhase) {
+    case STROKE_PHASE_RECOVERY:
+      if (!detector.inStroke &&
+          detector.lastStrokeTime != 0 &&
+          (timeMs - detector.lastStrokeTime) < STROKE_MIN_INTERVAL_MS) {
+        break;
+      }
+      // Waiting for catch - arm on a gyro onset (blade entry), confirm with acceleration
+      if (!detector.gyroArmed) {
+        if (gyroRate > CATCH_GYRO_RATE_DPS && gyroRise > CATCH_GYRO_RISE_DPS) {
+          detector.gyroArmed = true;
+          detector.gyroOnsetTime = timeMs;
+        }
+      } else if (timeMs - detector.gyroOnsetTime > CATCH_CONFIRM_WINDOW_MS) {
+        // Paddle rotation without a drive (e.g. feathering during recovery)
+        detector.gyroArmed = false;
+        detector.stats.rejectedOnsets++;
+      }
+
+      {
+        bool gyroConfirmed = detector.gyroArmed &&
+                             strokeAccel > threshold * CATCH_CONFIRM_ACCEL_RATIO;
+
+        // Accel-only threshold crossing still catches strokes the gyro missed
+        if (gyroConfirmed || strokeAccel > threshold) {
+          detector.maxAccel = strokeAccel;
+          detector.inStroke = true;
+          detector.gyroArmed = false;
+          detector.catchTime = gyroConfirmed ? detector.gyroOnsetTime : timeMs;
+          enterPhase(detector, step, STROKE_PHASE_CATCH, detector.catchTime);
+          step.gyroCatch = gyroConfirmed;
+
+          if (gyroConfirmed) {
+            detector.stats.gyroCatches++;
+            if (strokeAccel > threshold) {
+              recordCatchLead(detector, step, timeMs - detector.catchTime);
+            } else {
+              detector.accelCatchPending = true;
+            }
+          } else {
+            detector.stats.accelOnlyCatches++;
+          }
+        }
+      }
+      break;
+
+    case STROKE_PHASE_CATCH:
+      // Track peak acceleration during drive
+      if (strokeAccel > detector.maxAccel) {
+        detector.maxAccel = strokeAccel;
+      }
+
+      // Measure how much later the accel-only detector would have fired
+      if (detector.accelCatchPending && strokeAccel > threshold) {
+        detector.accelCatchPending = false;
+        recordCatchLead(detector, step, timeMs - detector.catchTime);
+      }
+
+      // Transition to drive when acceleration starts decreasing (from peak ~1.8g to ~1.2g)
+      if (strokeAccel < detector.maxAccel * 0.65) {
+        if (detector.accelCatchPending) {
+          // Accel never reached the threshold - this stroke would have been missed entirely
+          detector.accelCatchPending = false;
+          detector.stats.gyroOnlyCatches++;
+        }
+        detector.driveTime = timeMs;
+        enterPhase(detector, step, STROKE_PHASE_DRIVE, timeMs);
+      }
+      break;
+
+    case STROKE_PHASE_DRIVE:
+      // Detect finish - when acceleration crosses near zero (based on paddle data: 0 to -0.5g range)
+      if (strokeAccel < 0.0) {
+        detector.minAccel = strokeAccel;
+        detector.finishTime = timeMs;
+        detector.lastStrokeTime = timeMs;
+        enterPhase(detector, step, STROKE_PHASE_FINISH, timeMs);
+      }
+      break;
+
+    case STROKE_PHASE_FINISH:
+      // Track minimum (most negative) acceleration during recovery (expected ~-2.4g)
+      if (strokeAccel < detector.minAccel) {
+        detector.minAccel = strokeAccel;
+      }
+
+      // Return to recovery phase when acceleration returns toward positive (recovery ends around -0.5g to 0g).
+      // Peak and minimum are left in place so the caller can still pack the stroke record.
+      if (strokeAccel > -0.5) {
+        detector.inStroke = false;
+        enterPhase(detector, step, STROKE_PHASE_RECOVERY, timeMs);
+      }
+      break;
+  }
+
+  return step;
+}
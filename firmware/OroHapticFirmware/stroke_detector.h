@@ -0,0 +1,89 @@
+/*
+ * Stroke Phase Detector for Oro Haptic Paddle
+ *
+ * Pure state machine: each call takes one IMU sample (timestamp, stroke-axis
+ * acceleration in g, angular rate magnitude in deg/s) and reports the phase the
+ * stroke entered, if any. It reads no sensors and has no side effects, so the
+ * sketch owns the IMU, haptic blanking and what happens on each transition, and
+ * tools/catch_replay runs the identical code on recorded samples on a host.
+ *
+ * Catch detection is gyro-first: blade entry shows up as an angular-rate spike
+ * before forward acceleration builds, so a gyro onset arms the catch and a lower
+ * accel level confirms it. An accel-only threshold crossing still catches strokes
+ * the gyro missed. For every gyro catch the detector keeps running the accel-only
+ * rule until the drive, which measures how much earlier the gyro path fired.
+ *
+ * Only standard headers are used so the file builds unchanged with the Arduino
+ * toolchain and with a host compiler.
+ */
+
+#ifndef STROKE_DETECTOR_H
+#define STROKE_DETECTOR_H
+
+#include <stdint.h>
+
+#define STROKE_MIN_INTERVAL_MS 200   // Minimum time between strokes (prevents double-counting)
+
+// Gyro-first catch detection thresholds
+#define CATCH_GYRO_RATE_DPS 120.0      // Angular rate magnitude that marks blade entry (deg/s)
+#define CATCH_GYRO_RISE_DPS 15.0       // Minimum sample-to-sample rise in angular rate (rules out steady rotation)
+#define CATCH_CONFIRM_WINDOW_MS 150    // Accel must confirm a gyro onset within this window
+#define CATCH_CONFIRM_ACCEL_RATIO 0.5  // Confirmation level as a fraction of the accel threshold
+
+// Stroke Phases
+enum StrokePhase {
+  STROKE_PHASE_CATCH = 0x01,    // Start of stroke (paddle entry/catch)
+  STROKE_PHASE_DRIVE = 0x02,    // Power phase (drive/pull)
+  STROKE_PHASE_FINISH = 0x03,   // End of stroke (finish/extraction)
+  STROKE_PHASE_RECOVERY = 0x04  // Return to catch position
+};
+
+// Catch detection latency statistics (gyro-first vs accel-only threshold crossing)
+struct CatchLatencyStats {
+  uint16_t gyroCatches;          // Catches armed by the gyro and confirmed by accel
+  uint16_t accelOnlyCatches;     // Catches where accel crossed the threshold without a gyro onset
+  uint16_t gyroOnlyCatches;      // Gyro catches the accel-only detector would have missed
+  uint16_t rejectedOnsets;       // Gyro onsets that were never confirmed
+  uint16_t leadSamples;          // Catches with a measured lead over the accel-only detector
+  uint32_t leadSumMs;
+  uint16_t leadMinMs;
+  uint16_t leadMaxMs;
+};
+
+struct StrokeDetector {
+  StrokePhase currentPhase;
+  uint32_t lastStrokeTime;
+  float maxAccel;                // Peak acceleration of the current stroke (valid until the next catch)
+  float minAccel;                // Minimum (most negative) during recovery (valid until the next finish)
+  bool inStroke;                 // Currently in a stroke cycle
+  float prevGyroRate;            // Angular rate magnitude of the previous sample (deg/s)
+  bool gyroArmed;                // Gyro onset seen, waiting for accel confirmation
+  uint32_t gyroOnsetTime;        // Time of the gyro onset that armed the catch
+  uint32_t catchTime;            // Reported time of the current catch
+  bool accelCatchPending;        // Waiting for the accel-only detector to catch up (lead measurement)
+  uint32_t driveTime;            // Phase transition times of the current stroke
+  uint32_t finishTime;
+  CatchLatencyStats stats;
+};
+
+// Result of one sample. phaseTime is the reported time of the new phase - for a
+// gyro catch that is the onset, earlier than the sample that confirmed it.
+struct StrokeStep {
+  bool transition;               // A phase was entered on this sample
+  StrokePhase phase;
+  uint32_t phaseTime;
+  bool gyroCatch;                // Catch came from the gyro path
+  bool leadMeasured;             // The accel-only detector fired on this sample
+  uint16_t leadMs;               // ... this long after the reported catch
+};
+
+void strokeDetectorReset(StrokeDetector& detector);
+
+// Sample after a gap in clean data (haptic blanking, calibration): take it as the
+// gyro baseline so the jump is not mistaken for an onset
+void strokeDetectorReseed(StrokeDetector& detector, float gyroRate);
+
+StrokeStep strokeDetectorUpdate(StrokeDetector& detector, uint32_t timeMs,
+                                float strokeAccel, float gyroRate, float threshold);
+
+#endif // STROKE_DETECTOR_H
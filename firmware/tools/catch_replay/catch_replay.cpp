@@ -0,0 +1,148 @@
+/*
+ * Catch Detection Replay for Oro Haptic Paddle
+ *
+ * Runs the firmware's stroke detector (OroHapticFirmware/stroke_detector.cpp, the
+ * same source the sketch compiles) over a recorded IMU session on a host and
+ * reports how much earlier the gyro-first catch fires than the accel-only
+ * threshold crossing, and which strokes only one of the two detectors found.
+ *
+ * Recording: open the serial monitor at 115200, send 'm' to toggle the IMU sample
+ * log, paddle, send 'm' again and save the whole capture. Lines that do not start
+ * with "IMU," are skipped, so the raw capture can be fed in unchanged:
+ *
+ *   IMU,<time_ms>,<accel_g>,<gyro_dps>,<reseed>
+ *
+ * accel_g and gyro_dps are the values the detector saw (after haptic blanking);
+ * reseed marks the first clean sample after a blanked stretch.
+ *
+ * Build and run:
+ *   g++ -std=c++11 -O2 -I../../OroHapticFirmware catch_replay.cpp \
+ *       ../../OroHapticFirmware/stroke_detector.cpp -o catch_replay
+ *   ./catch_replay [-t threshold_g] [-v] session.log
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "stroke_detector.h"
+
+#define DEFAULT_THRESHOLD_G 1.0  // STROKE_DETECT_THRESHOLD in the sketch
+
+struct ReplayRun {
+  StrokeDetector detector;
+  uint32_t strokes;              // Completed strokes (finish transitions)
+};
+
+static void usage(const char* name) {
+  fprintf(stderr, "usage: %s [-t threshold_g] [-v] <session.log | ->\n", name);
+}
+
+int main(int argc, char** argv) {
+  float threshold = DEFAULT_THRESHOLD_G;
+  bool verbose = false;
+  const char* path = NULL;
+
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "-t") == 0 && i + 1 < argc) {
+      threshold = (float)atof(argv[++i]);
+    } else if (strcmp(argv[i], "-v") == 0) {
+      verbose = true;
+    } else if (path == NULL) {
+      path = argv[i];
+    } else {
+      usage(argv[0]);
+      return 2;
+    }
+  }
+  if (path == NULL || threshold <= 0.0) {
+    usage(argv[0]);
+    return 2;
+  }
+
+  FILE* in = strcmp(path, "-") == 0 ? stdin : fopen(path, "r");
+  if (in == NULL) {
+    perror(path);
+    return 1;
+  }
+
+  // Gyro-first detector as shipped, and the accel-only baseline (no angular rate, so it never arms)
+  ReplayRun gyroRun;
+  ReplayRun accelRun;
+  strokeDetectorReset(gyroRun.detector);
+  strokeDetectorReset(accelRun.detector);
+  gyroRun.strokes = 0;
+  accelRun.strokes = 0;
+
+  char line[256];
+  uint32_t samples = 0;
+  uint32_t firstMs = 0;
+  uint32_t lastMs = 0;
+
+  while (fgets(line, sizeof(line), in) != NULL) {
+    const char* record = strstr(line, "IMU,");
+    if (record == NULL) {
+      continue;
+    }
+
+    unsigned long timeMs;
+    float accel;
+    float gyro;
+    int reseed;
+    if (sscanf(record, "IMU,%lu,%f,%f,%d", &timeMs, &accel, &gyro, &reseed) != 4) {
+      continue;
+    }
+
+    if (samples == 0) firstMs = (uint32_t)timeMs;
+    lastMs = (uint32_t)timeMs;
+    samples++;
+
+    if (reseed) {
+      strokeDetectorReseed(gyroRun.detector, gyro);
+    }
+
+    StrokeStep step = strokeDetectorUpdate(gyroRun.detector, (uint32_t)timeMs, accel, gyro, threshold);
+    StrokeStep baseline = strokeDetectorUpdate(accelRun.detector, (uint32_t)timeMs, accel, 0.0, threshold);
+
+    if (step.transition && step.phase == STROKE_PHASE_FINISH) gyroRun.strokes++;
+    if (baseline.transition && baseline.phase == STROKE_PHASE_FINISH) accelRun.strokes++;
+
+    if (verbose) {
+      if (step.transition && step.phase == STROKE_PHASE_CATCH) {
+        printf("%10lu  catch %-5s at %lu\n", timeMs, step.gyroCatch ? "gyro" : "accel",
+               (unsigned long)step.phaseTime);
+      }
+      if (step.leadMeasured) {
+        printf("%10lu  lead over accel-only %u ms\n", timeMs, step.leadMs);
+      }
+      if (baseline.transition && baseline.phase == STROKE_PHASE_CATCH) {
+        printf("%10lu  baseline catch\n", timeMs);
+      }
+    }
+  }
+  if (in != stdin) {
+    fclose(in);
+  }
+
+  if (samples == 0) {
+    fprintf(stderr, "%s: no IMU sample lines found\n", path);
+    return 1;
+  }
+
+  const CatchLatencyStats& stats = gyroRun.detector.stats;
+  printf("Samples:                %lu over %.1f s (threshold %.2f g)\n",
+         (unsigned long)samples, (lastMs - firstMs) / 1000.0, threshold);
+  printf("Strokes (gyro-first):   %lu\n", (unsigned long)gyroRun.strokes);
+  printf("Strokes (accel-only):   %lu\n", (unsigned long)accelRun.strokes);
+  printf("Gyro-confirmed catches: %u\n", stats.gyroCatches);
+  printf("Accel-only catches:     %u\n", stats.accelOnlyCatches);
+  printf("Missed by accel-only:   %u\n", stats.gyroOnlyCatches);
+  printf("Rejected gyro onsets:   %u\n", stats.rejectedOnsets);
+  if (stats.leadSamples > 0) {
+    printf("Lead over accel-only (ms): avg %.1f | min %u | max %u | n=%u\n",
+           stats.leadSumMs / (float)stats.leadSamples, stats.leadMinMs, stats.leadMaxMs,
+           stats.leadSamples);
+  } else {
+    printf("No lead measurements\n");
+  }
+  return 0;
+}